@@ -517,11 +517,13 @@ struct hrmap_archimedean : hrmap {
     }
 
   ~hrmap_archimedean() {
-    if(hyperbolic) for(auto& p: archimedean_gmatrix) if(p.second.first->cdata) {
-      delete p.second.first->cdata;
-      p.second.first->cdata = NULL;
+    if(!bulk_release()) {
+      if(hyperbolic) for(auto& p: archimedean_gmatrix) if(p.second.first->cdata) {
+        tailored_delete(p.second.first->cdata);
+        p.second.first->cdata = NULL;
+        }
+      clearfrom(origin);
       }
-    clearfrom(origin);
     altmap.clear();
     archimedean_gmatrix.clear();
     if(current_altmap) {
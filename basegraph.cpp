@@ -10,7 +10,136 @@ namespace hr {
 
 EX int fontscale = 100;
 
+/** the number of lookups in gmatrix/gmatrix0 in the current frame, and the number of them which found the cell */
+EX int gmatrix_probes, gmatrix_found;
+
+/** the values of gmatrix_probes and gmatrix_found for the last complete frame */
+EX int last_gmatrix_probes, last_gmatrix_found;
+
+/** show last_gmatrix_probes in the HUD, next to the fps */
+EX bool show_gmatrix_probes = false;
+
+/** the number of lookups in the text caches (laid out strings in OpenGL, rendered texts in SDL) in the current frame, and the number of hits */
+EX int text_cache_lookups, text_cache_hits;
+
+/** the number of texts drawn with OpenGL in the current frame, and the number of batches they were merged into */
+EX int frame_texts_merged, frame_text_batches;
+
+/** the values of the text statistics for the last complete frame */
+EX int last_text_cache_lookups, last_text_cache_hits, last_texts_merged, last_text_batches;
+
+/** show the text statistics in the HUD, next to the fps */
+EX bool show_text_stats = false;
+
 #if HDR
+/** A table of cell matrices, used for gmatrix. It provides the part of the
+ *  interface of unordered_map<cell*, transmatrix> that is used for gmatrix,
+ *  but cells are found by their cell::mapid in an index where each entry is
+ *  stamped with the frame it was set in, so clear() is O(1), and a lookup is
+ *  one compare and one index.
+ */
+struct cellmatrix_table {
+  typedef pair<cell*, transmatrix> value_type;
+  /** entries are kept in blocks of this size, so that adding entries never moves the existing ones */
+  static const int BLOCK = 256;
+  vector<vector<value_type>> blocks;
+  /** the number of entries in use */
+  int qty;
+  /** for each cell::mapid: the stamp at which it has been added, and its entry */
+  vector<pair<int, int>> index;
+  /** the current stamp, changed by clear() */
+  int stamp;
+  /** entries of cells whose mapid has been already used by a cell from another map */
+  map<cell*, int> collisions;
+
+  value_type& entry(int i) { return blocks[i / BLOCK][i % BLOCK]; }
+  const value_type& entry(int i) const { return blocks[i / BLOCK][i % BLOCK]; }
+
+  int find_entry(cell *c) const {
+    gmatrix_probes++;
+    int id = c->mapid;
+    if(id >= isize(index) || index[id].first != stamp) return -1;
+    int i = index[id].second;
+    if(entry(i).first != c) {
+      auto it = collisions.find(c);
+      if(it == collisions.end()) return -1;
+      i = it->second;
+      }
+    gmatrix_found++;
+    return i;
+    }
+
+  int add_entry(cell *c) {
+    int i = qty++;
+    if(i / BLOCK >= isize(blocks)) blocks.emplace_back(), blocks.back().resize(BLOCK);
+    auto& e = entry(i);
+    e.first = c; e.second = transmatrix();
+    int id = c->mapid;
+    if(id >= isize(index)) index.resize(id+1, make_pair(0, 0));
+    if(index[id].first == stamp) collisions[c] = i;
+    else index[id] = make_pair(stamp, i);
+    return i;
+    }
+
+  cellmatrix_table() { qty = 0; stamp = 1; }
+  cellmatrix_table(const cellmatrix_table& t) : cellmatrix_table() { *this = t; }
+  cellmatrix_table(cellmatrix_table&& t) : cellmatrix_table() { swap(t); }
+
+  cellmatrix_table& operator = (const cellmatrix_table& t) {
+    if(this == &t) return *this;
+    clear();
+    for(int i=0; i<t.qty; i++) (*this)[t.entry(i).first] = t.entry(i).second;
+    return *this;
+    }
+
+  cellmatrix_table& operator = (cellmatrix_table&& t) {
+    swap(t); t.clear();
+    return *this;
+    }
+
+  void swap(cellmatrix_table& t) {
+    blocks.swap(t.blocks); index.swap(t.index); collisions.swap(t.collisions);
+    std::swap(qty, t.qty); std::swap(stamp, t.stamp);
+    }
+
+  friend void swap(cellmatrix_table& a, cellmatrix_table& b) { a.swap(b); }
+
+  void clear() {
+    qty = 0;
+    if(!collisions.empty()) collisions.clear();
+    stamp++;
+    }
+
+  int size() const { return qty; }
+  int count(cell *c) const { return find_entry(c) >= 0; }
+
+  transmatrix& operator [] (cell *c) {
+    int i = find_entry(c);
+    if(i < 0) i = add_entry(c);
+    return entry(i).second;
+    }
+
+  transmatrix& at(cell *c) {
+    int i = find_entry(c);
+    if(i < 0) throw out_of_range("cellmatrix_table::at");
+    return entry(i).second;
+    }
+
+  struct iterator {
+    cellmatrix_table *t;
+    int i;
+    value_type& operator * () const { return t->entry(i); }
+    value_type* operator -> () const { return &t->entry(i); }
+    iterator& operator ++ () { i++; return *this; }
+    iterator operator ++ (int) { iterator it = *this; i++; return it; }
+    bool operator == (const iterator& it) const { return i == it.i; }
+    bool operator != (const iterator& it) const { return i != it.i; }
+    };
+
+  iterator begin() { return iterator{this, 0}; }
+  iterator end() { return iterator{this, qty}; }
+  };
+
 /** configuration of the current view */
 struct display_data {
   /** This specifies the heptagon the view is currently centered on. 
@@ -24,7 +153,7 @@ struct display_data {
   /** The cell which is precisely in the center. */
   cellwalker precise_center;
   /** On-screen coordinates for all the visible cells. */
-  unordered_map<cell*, transmatrix> cellmatrices, old_cellmatrices;
+  cellmatrix_table cellmatrices, old_cellmatrices;
   /** Position of the current map view, relative to the screen (0 to 1). */
   ld xmin, ymin, xmax, ymax;
   /** Position of the current map view, in pixels. */
@@ -359,6 +488,12 @@ typedef Uint16 texturepixel;
 int curx = 0, cury = 0, theight = 0;
 texturepixel fontdata[FONTTEXTURESIZE][FONTTEXTURESIZE];
 
+/** the glyphs of all the font sizes are kept in a single texture, so that texts of different sizes can be drawn in one batch */
+GLuint glfont_texture;
+
+/** set when a glyph did not fit in the texture */
+bool glfont_atlas_full;
+
 void sdltogl(SDL_Surface *txt, glfont_t& f, int ch) {
 #if CAP_TABFONT
   if(ch < 32) return;
@@ -373,6 +508,8 @@ void sdltogl(SDL_Surface *txt, glfont_t& f, int ch) {
   
   if(otwidth+curx > FONTTEXTURESIZE) curx = 0, cury += theight, theight = 0;
   
+  if(cury + otheight > FONTTEXTURESIZE) { glfont_atlas_full = true; return; }
+  
   theight = max(theight, otheight);
   
   for(int j=0; j<otheight;j++) for(int i=0; i<otwidth; i++) {
@@ -394,6 +531,25 @@ void sdltogl(SDL_Surface *txt, glfont_t& f, int ch) {
   curx += otwidth;
   }
   
+/** laid out strings for gl_print, relative to the left end of the baseline */
+struct text_layout {
+  vector<glhr::textured_vertex> vertices;
+  int width, height;
+  };
+
+/** laid out strings, keyed by (text, size + 256 * frame) */
+hashtable<pair<string, int>, text_layout> text_layouts;
+
+/** forget all the glyphs */
+void reset_glfont_atlas() {
+  for(int i=0; i<256; i++) if(glfont[i]) {
+    delete glfont[i];
+    glfont[i] = NULL;
+    }
+  curx = 0, cury = 0, theight = 0;
+  text_layouts.clear();
+  }
+
 void init_glfont(int size) {
   if(glfont[size]) return;
   DEBBI(DF_GRAPH, ("init GL font: ", size));
@@ -408,7 +564,6 @@ void init_glfont(int size) {
   glfont_t& f(*(glfont[size]));
 
 //f.list_base = glGenLists(128);
-  glGenTextures(1, &f.texture );
 
 #if !CAP_TABFONT
   char str[2]; str[1] = 0;
@@ -423,7 +578,9 @@ void init_glfont(int size) {
   
 //  glListBase(0);
 
-  curx = 0, cury = 0, theight = 0;
+  int y0 = cury;
+  bool was_empty = cury == 0 && curx == 0;
+  glfont_atlas_full = false;
   
   for(int ch=1;ch<CHARS;ch++) {
   
@@ -450,17 +607,32 @@ void init_glfont(int size) {
 #endif
     }
 
-  glBindTexture( GL_TEXTURE_2D, f.texture);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-  
-  theight = next_p2(cury + theight);
-  
-  glTexImage2D( GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, FONTTEXTURESIZE, theight, 0,
-    GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, 
-    fontdata);
+  if(glfont_atlas_full) {
+    /* the texts already queued refer to the old glyphs */
+    glflush();
+    reset_glfont_atlas();
+    if(!was_empty) init_glfont(size);
+    return;
+    }
+
+  if(!glfont_texture) {
+    glGenTextures(1, &glfont_texture);
+    glBindTexture( GL_TEXTURE_2D, glfont_texture);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
+    glTexImage2D( GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, FONTTEXTURESIZE, FONTTEXTURESIZE, 0,
+      GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, 
+      fontdata);
+    }
+  else {
+    glBindTexture( GL_TEXTURE_2D, glfont_texture);
+    glTexSubImage2D( GL_TEXTURE_2D, 0, 0, y0, FONTTEXTURESIZE, cury + theight - y0,
+      GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, 
+      fontdata[y0]);
+    }
+  f.texture = glfont_texture;
 
-  for(int ch=0; ch<CHARS; ch++) f.ty0[ch] /= theight, f.ty1[ch] /= theight;
+  for(int ch=0; ch<CHARS; ch++) f.ty0[ch] /= FONTTEXTURESIZE, f.ty1[ch] /= FONTTEXTURESIZE;
  
 #if CAP_CREATEFONT
   printf("#define NUMEXTRA %d\n", NUMEXTRA);
@@ -507,7 +679,63 @@ glhr::textured_vertex charvertex(int x1, int y1, ld tx, ld ty) {
   return res;
   }
 
-bool gl_print(int x, int y, int shift, int size, const char *s, color_t color, int align) {
+/** the offsets of the copies of the text drawn by displayfr for the given frame width, in the order in which they are drawn */
+vector<pair<int, int>> frame_offsets(int b) {
+  if(b == 0) return {{0, 0}};
+  vector<pair<int, int>> res = {{-b, 0}, {b, 0}, {0, -b}, {0, b}};
+  int b1 = b-1;
+  if(b >= 2) res.insert(res.end(), {{-b1, -b1}, {-b1, b1}, {b1, -b1}, {b1, b1}});
+  return res;
+  }
+
+text_layout& get_layout(glfont_t& f, int gsiz, int size, const char *s, int frame) {
+  static pair<string, int> key;
+  key.first.assign(s);
+  key.second = size + 256 * frame;
+  text_cache_lookups++;
+  auto it = text_layouts.find(key);
+  if(it != text_layouts.end()) {
+    text_cache_hits++;
+    return it->second;
+    }
+  if(text_layouts.size() >= 4096) text_layouts.clear();
+  
+  auto& l = text_layouts[key];
+  
+  l.width = 0;
+  for(int i=0; s[i];) {
+    l.width += f.widths[getnext(s,i)] * size/gsiz;
+    }
+  l.height = f.heights[32] * size / gsiz;
+  
+  for(auto off: frame_offsets(frame)) {
+    int x = off.first, y = off.second;
+    for(int i=0; s[i];) {
+    
+      int tabid = getnext(s,i);
+      int wi = f.widths[tabid] * size/gsiz;
+      int hi = f.heights[tabid] * size/gsiz;
+    
+      glhr::textured_vertex t00 = charvertex(x,    y-hi, f.tx0[tabid], f.ty0[tabid]);
+      glhr::textured_vertex t01 = charvertex(x,    y,    f.tx0[tabid], f.ty1[tabid]);
+      glhr::textured_vertex t11 = charvertex(x+wi, y,    f.tx1[tabid], f.ty1[tabid]);
+      glhr::textured_vertex t10 = charvertex(x+wi, y-hi, f.tx1[tabid], f.ty0[tabid]);
+      
+      l.vertices.push_back(t00);
+      l.vertices.push_back(t01);
+      l.vertices.push_back(t10);
+      l.vertices.push_back(t10);
+      l.vertices.push_back(t01);
+      l.vertices.push_back(t11);
+        
+      x += wi;
+      }
+    }
+  return l;
+  }
+
+/** print s; if frame is positive, print the copies forming a frame of that width around s (see displayfr) instead */
+bool gl_print(int x, int y, int shift, int size, const char *s, color_t color, int align, int frame = 0) {
   int gsiz = size;
   if(size > vid.fsize || size > 72) gsiz = 72;
 
@@ -520,17 +748,12 @@ bool gl_print(int x, int y, int shift, int size, const char *s, color_t color, i
 
   glfont_t& f(*glfont[gsiz]);
   
-  int tsize = 0;
+  auto& l = get_layout(f, gsiz, size, s, frame);
   
-  for(int i=0; s[i];) {
-    tsize += f.widths[getnext(s,i)] * size/gsiz;
-    }
-  x -= tsize * align / 16;
+  x -= l.width * align / 16;
   y += f.heights[32] * size / (gsiz*2);
   
-  int ysiz = f.heights[32] * size / gsiz;
-
-  bool clicked = (mousex >= x && mousey <= y && mousex <= x+tsize && mousey >= y-ysiz);
+  bool clicked = (mousex >= x && mousey <= y && mousex <= x+l.width && mousey >= y-l.height);
   
   color_t icolor = (color << 8) | 0xFF;
   if(icolor != text_color || f.texture != text_texture || shift != text_shift || shapes_merged) {
@@ -545,28 +768,9 @@ bool gl_print(int x, int y, int shift, int size, const char *s, color_t color, i
 
   glBindTexture(GL_TEXTURE_2D, f.texture);
 
-  for(int i=0; s[i];) {
-  
-    int tabid = getnext(s,i);
-    int wi = f.widths[tabid] * size/gsiz;
-    int hi = f.heights[tabid] * size/gsiz;
-
-    GLERR("pre-print");
-  
-    glhr::textured_vertex t00 = charvertex(x,    y-hi, f.tx0[tabid], f.ty0[tabid]);
-    glhr::textured_vertex t01 = charvertex(x,    y,    f.tx0[tabid], f.ty1[tabid]);
-    glhr::textured_vertex t11 = charvertex(x+wi, y,    f.tx1[tabid], f.ty1[tabid]);
-    glhr::textured_vertex t10 = charvertex(x+wi, y-hi, f.tx1[tabid], f.ty0[tabid]);
-    
-    tver.push_back(t00);
-    tver.push_back(t01);
-    tver.push_back(t10);
-    tver.push_back(t10);
-    tver.push_back(t01);
-    tver.push_back(t11);
-      
-    x += wi;
-    }
+  int first = isize(tver);
+  tver.insert(tver.end(), l.vertices.begin(), l.vertices.end());
+  for(int i=first; i<isize(tver); i++) tver[i].coords[0] += x, tver[i].coords[1] += y;
   
   return clicked;
   }
@@ -579,10 +783,8 @@ EX void resetGL() {
   DEBBI(DF_INIT | DF_GRAPH, ("reset GL"))
   callhooks(hooks_resetGL);
 #if CAP_GLFONT
-  for(int i=0; i<128; i++) if(glfont[i]) {
-    delete glfont[i];
-    glfont[i] = NULL;
-    }
+  reset_glfont_atlas();
+  glfont_texture = 0;
 #endif
 #if MAXMDIM >= 4
   if(floor_textures) {
@@ -670,6 +872,33 @@ EX bool displaystr(int x, int y, int shift, int size, char const *s, color_t col
 
 #endif
 #if !CAP_XGD
+#if CAP_SDLTTF
+/** rendered texts, keyed by (text, (size and antialiasing, color)) */
+hashtable<pair<string, pair<int, color_t>>, SDL_Surface*> text_surfaces;
+
+void clear_text_surfaces() {
+  for(auto& p: text_surfaces) if(p.second) SDL_FreeSurface(p.second);
+  text_surfaces.clear();
+  }
+
+SDL_Surface *render_text(int size, const char *str, SDL_Color col) {
+  static pair<string, pair<int, color_t>> key;
+  bool aa = vid.antialias & AA_FONT;
+  key.first.assign(str);
+  key.second = make_pair(size + (aa ? 256 : 0), (col.r << 16) | (col.g << 8) | col.b);
+  text_cache_lookups++;
+  auto it = text_surfaces.find(key);
+  if(it != text_surfaces.end()) {
+    text_cache_hits++;
+    return it->second;
+    }
+  if(text_surfaces.size() >= 1024) clear_text_surfaces();
+  SDL_Surface *txt = (aa?TTF_RenderUTF8_Blended:TTF_RenderUTF8_Solid)(font[size], str, col);
+  text_surfaces[key] = txt;
+  return txt;
+  }
+#endif
+
 EX bool displaystr(int x, int y, int shift, int size, const char *str, color_t color, int align) {
 
   if(strlen(str) == 0) return false;
@@ -697,7 +926,7 @@ EX bool displaystr(int x, int y, int shift, int size, const char *str, color_t c
 
   loadfont(size);
 
-  SDL_Surface *txt = ((vid.antialias & AA_FONT)?TTF_RenderUTF8_Blended:TTF_RenderUTF8_Solid)(font[size], str, col);
+  SDL_Surface *txt = render_text(size, str, col);
   
   if(txt == NULL) return false;
 
@@ -727,7 +956,6 @@ EX bool displaystr(int x, int y, int shift, int size, const char *str, color_t c
   else {
     SDL_BlitSurface(txt, NULL, s,&rect); 
     }
-  SDL_FreeSurface(txt);
   
   return clicked;
 #endif
@@ -738,6 +966,12 @@ EX bool displaystr(int x, int y, int shift, int size, const string &s, color_t c
   }
 
 EX bool displayfrSP(int x, int y, int sh, int b, int size, const string &s, color_t color, int align, int p) {
+#if CAP_GLFONT
+  if(b && vid.usingGL && size >= 4 && size <= 255 && s != "") {
+    gl_print(x, y, 0, size, s.c_str(), p, align, b);
+    return displaystr(x, y, 0, size, s, color, align);
+    }
+#endif
   if(b) {
     displaystr(x-b, y, 0, size, s, p, align);
     displaystr(x+b, y, 0, size, s, p, align);
@@ -1195,6 +1429,9 @@ EX void initgraph() {
 
 EX void cleargraph() {
   DEBBI(DF_INIT, ("clear graph"));
+#if CAP_SDLTTF && !CAP_XGD
+  clear_text_surfaces();
+#endif
 #if CAP_SDLTTF
   for(int i=0; i<256; i++) if(font[i]) TTF_CloseFont(font[i]);
 #endif
@@ -34,8 +34,8 @@ EX namespace binary {
     }
   
   #if DEBUG_BINARY_TILING
-  map<heptagon*, long long> xcode;
-  map<long long, heptagon*> rxcode;
+  hashtable<heptagon*, long long> xcode;
+  hashtable<long long, heptagon*> rxcode;
 
   long long expected_xcode(heptagon *h, int d) {
     auto r =xcode[h];
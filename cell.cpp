@@ -11,10 +11,24 @@
 namespace hr {
 
 #if HDR
+/** relative_matrix caches products of 2, 4, ..., 2^RELCACHE_LEVELS steps up the tree of heptagons */
+static const int RELCACHE_LEVELS = 4;
+/** the number of heptagon pairs memoized by relative_matrix */
+static const int RELMEMO_SIZE = 4096;
+
 struct hrmap {
+  /** the arena owned by this map, released in bulk when the map is destroyed; NULL for maps which allocate in their parent's arena */
+  tailored_arena *arena = nullptr;
+  /** can the destructor skip freeing cells and heptagons one by one, since the whole arena is released anyway? */
+  bool bulk_release() { return arena && !IRREGULAR; }
   virtual heptagon *getOrigin() { return NULL; }
   virtual cell *gamestart() { return getOrigin()->c7; }
-  virtual ~hrmap() { };
+  virtual ~hrmap() { 
+    if(arena) {
+      if(current_arena == arena) current_arena = NULL;
+      delete arena;
+      }
+    }
   virtual vector<cell*>& allcells() { return dcal; }
   virtual void verify() { }
   virtual void link_alt(const cellwalker& hs) { }
@@ -45,6 +59,29 @@ struct hrmap_standard : hrmap {
   void draw() override;
   transmatrix relative_matrix(cell *c2, cell *c1, const hyperpoint& point_hint) override;
   heptagon *create_step(heptagon *h, int direction) override;
+
+  /** products of heptmove along the move(0) chain of a heptagon, 2^(i+1) steps up, and their inverses */
+  struct relcache_entry {
+    heptagon *h;
+    int known;
+    transmatrix up[RELCACHE_LEVELS], down[RELCACHE_LEVELS];
+    };
+  /** memoized results of relative_matrix, for a pair of cell::mapid values */
+  struct relmemo_entry {
+    int id1, id2;
+    transmatrix T;
+    };
+  /** the geometry the caches have been computed for */
+  struct geometry_information *relcache_cgi = nullptr;
+  /** relcache entry for each heptagon, indexed by c7->mapid; -1 if none */
+  vector<int> relcache_index;
+  vector<relcache_entry> relcache;
+  /** direct-mapped, indexed by a hash of both mapids */
+  vector<relmemo_entry> relmemo;
+  void clear_relcache();
+  const transmatrix& chain_matrix(heptagon *h, int lev, bool inverse);
+  transmatrix chain_product(heptagon *h, int steps, bool inverse);
+  transmatrix tree_relative_matrix(heptagon *h2, transmatrix where, heptagon *h1, transmatrix gm);
   };
 
 void clearfrom(heptagon*);
@@ -60,7 +97,7 @@ struct hrmap_hyperbolic : hrmap_standard {
     // verifycells(origin);
     // printf("Deleting hyperbolic map: %p\n", this);
     dynamicval<eVariation> ph(variation, mvar);
-    clearfrom(origin);
+    if(!bulk_release()) clearfrom(origin);
     }
   void verify() override { verifycells(origin); }
   };
@@ -75,10 +112,42 @@ EX int dirdiff(int dd, int t) {
 
 EX int cellcount = 0;
 
+/** bytes used by cells, heptagons, and other objects (cdata) in all the arenas */
+EX long long cellbytes, heptabytes, databytes;
+
+/** bytes in the slabs of all the arenas; the slots freed by tailored_delete stay reserved until the arena is destroyed */
+EX long long arenabytes;
+
+EX tailored_arena *current_arena;
+
+/** used when there is no current map, never released */
+tailored_arena *global_arena;
+
+tailored_arena *alloc_arena() {
+  if(current_arena) return current_arena;
+  if(!global_arena) global_arena = new tailored_arena;
+  return global_arena;
+  }
+
+tailored_arena::~tailored_arena() {
+  cellcount -= cells;
+  heptacount -= heptagons;
+  cellbytes -= cell_bytes;
+  heptabytes -= heptagon_bytes;
+  databytes -= data_bytes;
+  arenabytes -= bytes_reserved;
+  while(slabs) {
+    slab *s = slabs;
+    slabs = s->next;
+    free_slab(s);
+    }
+  }
+
 EX cell *newCell(int type, heptagon *master) {
   cell *c = tailored_alloc<cell> (type);
   c->type = type;
   c->master = master;
+  c->mapid = alloc_arena()->cell_ids++;
   initcell(c);
   return c;
   }
@@ -228,10 +297,20 @@ EX void eumerge(cell* c1, int s1, cell *c2, int s2, bool mirror) {
 
 EX hookset<hrmap*()> *hooks_newmap;
 
+/** is initcells() running? (it is called recursively for the underlying maps of product spaces) */
+bool creating_map;
+
 /** create a map in the current geometry */
 EX void initcells() {
   DEBB(DF_INIT, ("initcells"));
   
+  /* maps created recursively share the arena of the outer map */
+  bool own_arena = !creating_map;
+  dynamicval<bool> cm(creating_map, true);
+  #ifndef NO_TAILORED_ALLOC
+  if(own_arena) current_arena = new tailored_arena;
+  #endif
+
   hrmap* res = callhandlers((hrmap*)nullptr, hooks_newmap);
   if(res) currentmap = res;  
   else if(nonisotropic || hybri) currentmap = nisot::new_map();
@@ -260,6 +339,7 @@ EX void initcells() {
   else if(S3 >= OINF) currentmap = inforder::new_map();
   else currentmap = new hrmap_hyperbolic;
   
+  if(own_arena) currentmap->arena = current_arena;
   allmaps.push_back(currentmap);
 
   #if CAP_FIELD
@@ -300,7 +380,7 @@ template<class T> void subcell(cell *c, const T& t) {
 
 EX void clearHexes(heptagon *at) {
   if(at->c7 && at->cdata) {
-    delete at->cdata;
+    tailored_delete(at->cdata);
     at->cdata = NULL;
     }
   if(0);
@@ -676,7 +756,7 @@ cdata *getHeptagonCdata_legacy(heptagon *h) {
   if(sphere || quotient) h = currentmap->gamestart()->master;
 
   if(h == currentmap->getOrigin()) {
-    h->cdata = new cdata(orig_cdata);
+    h->cdata = arena_new<cdata>(orig_cdata);
     for(int& v: h->cdata->val) v = 0;
     h->cdata->bits = reptilecheat ? (1 << 21) - 1 : 0;
     if(yendor::on && specialland == laVariant) h->cdata->bits |= (1 << 8) | (1 << 9) | (1 << 12);
@@ -735,7 +815,7 @@ cdata *getHeptagonCdata_legacy(heptagon *h) {
     affect(mydata, hs.spin ? hs.at->rval0 : hs.at->rval1, signum);
     }
 
-  return h->cdata = new cdata(mydata);
+  return h->cdata = arena_new<cdata>(mydata);
   }
 
 
@@ -753,7 +833,7 @@ cdata *getHeptagonCdata(heptagon *h) {
     }
 
   if(starting) {
-    h->cdata = new cdata(orig_cdata);
+    h->cdata = arena_new<cdata>(orig_cdata);
     for(int& v: h->cdata->val) v = 0;
     h->cdata->bits = reptilecheat ? (1 << 21) - 1 : 0;
     if(yendor::on && specialland == laVariant) h->cdata->bits |= (1 << 8) | (1 << 9) | (1 << 12);
@@ -792,7 +872,7 @@ cdata *getHeptagonCdata(heptagon *h) {
     affect(mydata, hs.spin == dir ? hs.at->rval0 : hs.at->rval1, 1);
     }
 
-  return h->cdata = new cdata(mydata);
+  return h->cdata = arena_new<cdata>(mydata);
   }
 
 cdata *getEuclidCdata(int h) {
@@ -939,42 +1019,139 @@ EX int heptdistance(cell *c1, cell *c2) {
   else return heptdistance(c1->master, c2->master);
   }
 
-map<pair<cell*, cell*>, int> saved_distances;
+/** distances from a single source cell to the cells of its BFS ball, stored densely in the order of the BFS,
+ *  with a small open addressing hash from cell::mapid to the slot
+ */
+struct distance_table {
+  /** mapids of the reached cells, by slot */
+  vector<int> ids;
+  /** distances of the reached cells, by slot */
+  vector<short> dists;
+  /** slots by the hash of the mapid, -1 if empty; the size is a power of two, at least twice the number of slots */
+  vector<int> index;
+  /** tables requested by permanent_long_distances are never evicted, and are not in distance_lru */
+  bool permanent;
+  /** position in distance_lru */
+  std::list<cell*>::iterator lru;
+  
+  void build(const celllister& cl) {
+    int N = isize(cl.lst);
+    ids.resize(N); dists.resize(N);
+    int size = 16;
+    while(size < 2 * N) size *= 2;
+    index.assign(size, -1);
+    for(int i=0; i<N; i++) {
+      ids[i] = cl.lst[i]->mapid; dists[i] = cl.dists[i];
+      size_t h = hashtable_hash((unsigned long long) ids[i]) & (size-1);
+      while(index[h] != -1) h = (h+1) & (size-1);
+      index[h] = i;
+      }
+    }
+  
+  int get(cell *c) {
+    size_t mask = index.size() - 1;
+    for(size_t h = hashtable_hash((unsigned long long) c->mapid) & mask;; h = (h+1) & mask) {
+      int i = index[h];
+      if(i == -1) return DISTANCE_UNKNOWN;
+      if(ids[i] == c->mapid) return dists[i];
+      }
+    }
+  
+  long long memory() {
+    return isize(ids) * (long long) (sizeof(int) + sizeof(short)) + isize(index) * (long long) sizeof(int);
+    }
+  };
+
+map<cell*, distance_table> distance_tables;
+
+/** the tables which may be evicted, the most recently used first */
+std::list<cell*> distance_lru;
+
+/** the most recently used table, to skip the map lookup for repeated queries */
+pair<cell*, distance_table*> last_distance_table;
 
-set<cell*> keep_distances_from;
+/** total number of cells in all the tables, and in the permanent ones */
+int distance_entries, perma_distances;
 
-set<cell*> dists_computed;
+static const int max_distance_entries = 1000000;
 
-int perma_distances;
+distance_table *find_distance_table(cell *c) {
+  distance_table *t;
+  if(last_distance_table.first == c) t = last_distance_table.second;
+  else {
+    auto it = distance_tables.find(c);
+    if(it == distance_tables.end()) return NULL;
+    t = &it->second;
+    last_distance_table = make_pair(c, t);
+    }
+  if(!t->permanent) distance_lru.splice(distance_lru.begin(), distance_lru, t->lru);
+  return t;
+  }
 
-EX void compute_saved_distances(cell *c1, int max_range, int climit) {
+/** evict the least recently used tables until we are back within max_distance_entries */
+void trim_distance_tables(cell *keep) {
+  while(distance_entries > perma_distances + max_distance_entries && !distance_lru.empty()) {
+    cell *c = distance_lru.back();
+    if(c == keep) return;
+    distance_lru.pop_back();
+    distance_entries -= isize(distance_tables[c].dists);
+    if(last_distance_table.first == c) last_distance_table = make_pair(nullptr, nullptr);
+    distance_tables.erase(c);
+    }
+  }
+
+distance_table& compute_distance_table(cell *c1, int max_range, int climit, bool permanent) {
     
   celllister cl(c1, max_range, climit, NULL);
 
-  for(int i=0; i<isize(cl.lst); i++)
-    saved_distances[make_pair(c1, cl.lst[i])] = cl.dists[i];
+  bool is_new = !distance_tables.count(c1);
+  auto& t = distance_tables[c1];
+  distance_entries -= isize(t.dists);
+  if(t.permanent) perma_distances -= isize(t.dists);
+  t.build(cl);
+  if(!is_new && !t.permanent) distance_lru.erase(t.lru);
+  t.permanent = t.permanent || permanent;
+  if(!t.permanent) distance_lru.push_front(c1), t.lru = distance_lru.begin();
+  distance_entries += isize(t.dists);
+  if(t.permanent) perma_distances += isize(t.dists);
+  last_distance_table = make_pair(c1, &t);
+  
+  trim_distance_tables(c1);
+  return t;
+  }
+
+/** memory used by the distance tables, in bytes */
+EX long long saved_distances_memory() {
+  /* 32 bytes for the tree node of distance_tables, 24 for the node of distance_lru */
+  long long total = 0;
+  for(auto& p: distance_tables) total += p.second.memory() + sizeof(p) + 32 + (p.second.permanent ? 0 : 24);
+  return total;
   }
 
 EX void permanent_long_distances(cell *c1) {
-  keep_distances_from.insert(c1);
   if(racing::on)
-    compute_saved_distances(c1, 300, 1000000);
+    compute_distance_table(c1, 300, 1000000, true);
   else
-    compute_saved_distances(c1, 120, 200000);
+    compute_distance_table(c1, 120, 200000, true);
   }
 
+/** forget all the distance tables except the permanent ones */
 EX void erase_saved_distances() {
-  saved_distances.clear(); dists_computed.clear();
-  
-  for(auto c: keep_distances_from) compute_saved_distances(c, 120, 200000);
-  perma_distances = isize(saved_distances);
+  for(auto it = distance_tables.begin(); it != distance_tables.end();) {
+    if(it->second.permanent) it++;
+    else {
+      distance_entries -= isize(it->second.dists);
+      distance_lru.erase(it->second.lru);
+      it = distance_tables.erase(it);
+      }
+    }
+  last_distance_table = make_pair(nullptr, nullptr);
   }
 
 EX cell *random_in_distance(cell *c, int d) {
   vector<cell*> choices;
-  for(auto& p: saved_distances) println(hlog, p);
-
-  for(auto& p: saved_distances) if(p.first.first == c && p.second == d) choices.push_back(p.first.second);
+  celllister cl(c, d+1, racing::on ? 1000000 : 200000, NULL);
+  for(int i=0; i<isize(cl.lst); i++) if(cl.dists[i] == d) choices.push_back(cl.lst[i]);
   println(hlog, "choices = ", isize(choices));
   if(choices.empty()) return NULL;
   return choices[hrand(isize(choices))];
@@ -1005,17 +1182,10 @@ EX int celldistance(cell *c1, cell *c2) {
   
   if(bounded) {
     
-    if(saved_distances.count(make_pair(c1,c2)))
-      return saved_distances[make_pair(c1,c2)];
-
-    celllister cl(c1, 100, 100000000, NULL);
-    for(int i=0; i<isize(cl.lst); i++)
-      saved_distances[make_pair(c1, cl.lst[i])] = cl.dists[i];
+    if(auto t = find_distance_table(c1)) return t->get(c2);
+    if(auto t = find_distance_table(c2)) return t->get(c1);
 
-    if(saved_distances.count(make_pair(c1,c2)))
-      return saved_distances[make_pair(c1,c2)];
-
-    return DISTANCE_UNKNOWN;
+    return compute_distance_table(c1, 100, 100000000, false).get(c2);
     }
   
   #if CAP_CRYSTAL
@@ -1024,20 +1194,13 @@ EX int celldistance(cell *c1, cell *c2) {
   
   if(masterless || archimedean || quotient || solnih || (penrose && euclid) || experimental || sl2 || nil) {
     
-    if(saved_distances.count(make_pair(c1,c2)))
-      return saved_distances[make_pair(c1,c2)];
-    
-    if(dists_computed.count(c1)) return DISTANCE_UNKNOWN;
-      
-    if(isize(saved_distances) > perma_distances + 1000000) erase_saved_distances();
-    compute_saved_distances(c1, 64, 1000);
+    if(auto t = find_distance_table(c1)) return t->get(c2);
+    if(auto t = find_distance_table(c2)) {
+      int d = t->get(c1);
+      if(d != DISTANCE_UNKNOWN) return d;
+      }
     
-   dists_computed.insert(c1);
-
-    if(saved_distances.count(make_pair(c1,c2)))
-      return saved_distances[make_pair(c1,c2)];
-      
-    return DISTANCE_UNKNOWN;
+    return compute_distance_table(c1, 64, 1000, false).get(c2);
     }
    
    if(S3 >= OINF) return inforder::celldistance(c1, c2);
@@ -1111,14 +1274,16 @@ EX vector<cell*> build_shortest_path(cell *c1, cell *c2) {
   }
 
 EX void clearCellMemory() {
-  for(int i=0; i<isize(allmaps); i++) 
+  /* alternate maps are deleted before the main map, since their heptagons live in its arena */
+  for(int i=isize(allmaps)-1; i>=0; i--) 
     if(allmaps[i])
       delete allmaps[i];
   allmaps.clear();
   last_cleared = NULL;
-  saved_distances.clear();
-  dists_computed.clear();
-  keep_distances_from.clear(); perma_distances = 0;
+  distance_tables.clear();
+  distance_lru.clear();
+  last_distance_table = make_pair(nullptr, nullptr);
+  distance_entries = perma_distances = 0;
   pd_from = NULL;
   }
 
@@ -62,6 +62,11 @@ struct celldrawer {
   void radar_grid();
   
   void do_viewdist();
+
+  bool can_retain();
+  size_t retained_stamp();
+  bool draw_retained();
+  void record_retained(int first);
   };
 
 inline void drawcell(const cellwalker& cw, const transmatrix& V) {
@@ -2362,6 +2367,157 @@ void celldrawer::draw_gravity_particles() {
     }
   }
 
+/** retained mode: the items queued for a cell are remembered in cell-local coordinates, and replayed with
+ *  the new matrix while the cell does not change, so that moving the view does not recompute them */
+EX bool retained_mode = false;
+
+/** in retained mode, every cell is recomputed at least once in this many milliseconds */
+EX int retained_period = 1000;
+
+/** the items queued for a cell in retained mode, with the matrices relative to the cell */
+struct retained_cell {
+  /** the dirty stamp (see celldrawer::retained_stamp) when recorded */
+  size_t stamp;
+  /** ticks when recorded */
+  int recorded;
+  /** the number of consecutive recordings which produced the same items; replayed only if positive */
+  int stable;
+  /** the aura contribution */
+  bool has_aura;
+  color_t aura_color;
+  int fd;
+  /** for each item, whether it is a line (otherwise it is the next one from polys) */
+  vector<bool> is_line;
+  vector<dqi_poly> polys;
+  vector<dqi_line> lines;
+  };
+
+hashtable<cell*, retained_cell> retained;
+
+/** the part of the dirty stamp shared by all the cells, and whether retained mode is usable in this frame */
+size_t retained_global;
+bool retained_ok;
+int retained_frame = -1;
+
+auto retained_hooks = 
+  addHook(clearmemory, 0, [] () { retained.clear(); }) +
+  addHook(hooks_removecells, 0, [] () { retained.clear(); });
+
+bool celldrawer::can_retain() {
+  if(retained_frame != frameid) {
+    retained_frame = frameid;
+    retained_ok = retained_mode && GDIM == 2 && !shmup::on && !history::on && !viewdists &&
+      !(cmode & (sm::DRAW | sm::MAP | sm::TORUSCONFIG));
+    #if CAP_TEXTURE
+    if(texture::config.tstate == texture::tsActive) retained_ok = false;
+    #endif
+    #if CAP_MODEL
+    if(netgen::mode) retained_ok = false;
+    #endif
+    array<long long, 11> key = {{turncount, (long long) (size_t) cwt.at, cwt.spin, darken, inHighQual, cmode, 
+      vid.wallmode, vid.monmode, (long long) (size_t) cgip, (long long) (size_t) currentmap, settings_revision}};
+    retained_global = hashtable_hash(key);
+    if(isize(retained) > 4 * vid.cells_drawn_limit) retained.clear();
+    }
+  /* the colors of the cell under the mouse may depend on the hover */
+  if(!retained_ok || inmirrorcount || isPlayerOn(c) || c == lmouseover) return false;
+  for(auto& a: animations) if(a.count(c)) return false;
+  return true;
+  }
+
+/** changes when the cell changes, or the animation phase of the cell changes */
+size_t celldrawer::retained_stamp() {
+  int phase = (ticks + hashtable_hash(c) % retained_period) / retained_period;
+  array<long long, 15> key = {{c->wall, c->monst, c->item, c->land, c->wparam, c->landparam, c->mondir, c->stuntime, c->hitpoints,
+    c->cpdist, c->mpdist, cw.spin + 64 * cw.mirrored, detaillevel, phase, (long long) retained_global}};
+  return hashtable_hash(key);
+  }
+
+bool celldrawer::draw_retained() {
+  if(!can_retain()) return false;
+  auto it = retained.find(c);
+  if(it == retained.end()) return false;
+  auto& r = it->second;
+  if(r.stable <= 0 || r.stamp != retained_stamp()) return false;
+  int ip = 0, il = 0;
+  for(bool l: r.is_line) {
+    if(l) {
+      auto& src = r.lines[il++];
+      auto& ptd = queuea<dqi_line> (src.prio);
+      ptd = src;
+      ptd.H1 = V * src.H1; ptd.H2 = V * src.H2;
+      ptd.band_shift = band_shift;
+      }
+    else {
+      auto& src = r.polys[ip++];
+      auto& ptd = queuea<dqi_poly> (src.prio);
+      ptd = src;
+      ptd.V = V * src.V;
+      ptd.band_shift = band_shift;
+      }
+    }
+  if(r.has_aura) hr::addaura(tC0(V), darkened(r.aura_color), r.fd);
+  poly_outline = OUTLINE_DEFAULT;
+  return true;
+  }
+
+static bool same_matrix(const transmatrix& T1, const transmatrix& T2) {
+  for(int i=0; i<MDIM; i++) for(int j=0; j<MDIM; j++) if(abs(T1[i][j] - T2[i][j]) > 1e-6) return false;
+  return true;
+  }
+
+/** remember the items queued since first; the cell becomes stable if they are the same as in the previous recording */
+void celldrawer::record_retained(int first) {
+  if(!can_retain()) return;
+  auto& r = retained[c];
+  size_t st = retained_stamp();
+  transmatrix iV = iso_inverse(V);
+  bool same = r.stamp == st && r.recorded != ticks && isize(r.is_line) == isize(ptds) - first;
+  int ip = 0, il = 0;
+  static retained_cell nr;
+  nr.is_line.clear(); nr.polys.clear(); nr.lines.clear();
+  for(int i=first; i<isize(ptds); i++) {
+    auto p = &*ptds[i];
+    if(p->prio == PPR::TRANSPARENT_WALL) { r.stamp = 0; return; }
+    if(auto pp = dynamic_cast<dqi_poly*> (p)) {
+      if(pp->tab != &cgi.ourshape) { r.stamp = 0; return; }
+      nr.is_line.push_back(false);
+      nr.polys.push_back(*pp);
+      auto& n = nr.polys.back();
+      n.V = iV * pp->V;
+      if(same && (r.is_line[i-first] || ip >= isize(r.polys))) same = false;
+      if(same) {
+        auto& o = r.polys[ip++];
+        same = o.prio == n.prio && o.color == n.color && o.outline == n.outline && o.tab == n.tab && o.offset == n.offset &&
+          o.cnt == n.cnt && o.offset_texture == n.offset_texture && o.flags == n.flags && o.tinf == n.tinf &&
+          o.linewidth == n.linewidth && same_matrix(o.V, n.V);
+        }
+      }
+    else if(auto pl = dynamic_cast<dqi_line*> (p)) {
+      nr.is_line.push_back(true);
+      nr.lines.push_back(*pl);
+      auto& n = nr.lines.back();
+      n.H1 = iV * pl->H1; n.H2 = iV * pl->H2;
+      if(same && (!r.is_line[i-first] || il >= isize(r.lines))) same = false;
+      if(same) {
+        auto& o = r.lines[il++];
+        same = o.prio == n.prio && o.color == n.color && o.prf == n.prf && o.width == n.width &&
+          sqhypot_d(MDIM, o.H1 - n.H1) < 1e-12 && sqhypot_d(MDIM, o.H2 - n.H2) < 1e-12;
+        }
+      }
+    else { r.stamp = 0; return; }
+    }
+  r.stable = same ? r.stable + 1 : 0;
+  r.stamp = st;
+  r.recorded = ticks;
+  r.has_aura = true;
+  #if CAP_TEXTURE
+  if(texture::using_aura()) r.has_aura = false;
+  #endif
+  r.aura_color = aura_color; r.fd = fd;
+  swap(r.is_line, nr.is_line); swap(r.polys, nr.polys); swap(r.lines, nr.lines);
+  }
+
 void celldrawer::draw() {
   if(hybrid::pmap) { product::drawcell_stack(cw, V); return; }
 
@@ -2427,6 +2583,13 @@ void celldrawer::draw() {
     fd = getfd(c);
     error = false;
     
+    if(draw_retained()) {
+      check_rotations();
+      return;
+      }
+    
+    int retained_first = isize(ptds);
+    
     setcolors();
     
     tune_colors();
@@ -2491,6 +2654,8 @@ void celldrawer::draw() {
     if(WDIM == 2 && GDIM == 3) radar_grid();
     #endif
     
+    record_retained(retained_first);
+    
     check_rotations();
 
     #if CAP_EDIT
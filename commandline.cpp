@@ -344,6 +344,7 @@ namespace arg {
     curphase = phase;
     callhooks(hooks_config);
     while(pos < isize(argument)) {
+      settings_revision++;
       for(auto& h: *hooks_args) {
         int r = h.second(); if(r == 2) return; if(r == 0) { lshift(); goto cont; }
         }
@@ -339,6 +339,8 @@ EX void initConfig() {
   addsaver(rug::texturesize, "rug-texturesize");
 #if CAP_RUG
   addsaver(rug::model_distance, "rug-model-distance");
+  addsaver(rug::jacobi_physics, "rug-jacobi", false);
+  addsaver(rug::physics_threads, "rug-threads", 1);
 #endif
 
   addsaverenum(pmodel, "used model", mdDisk);
@@ -508,6 +510,12 @@ EX void initConfig() {
   addsaver(vid.smart_range_detail_3, "smart-range-detail", 30);
   addsaver(vid.cells_drawn_limit, "limit on cells drawn", 10000);
   addsaver(vid.cells_generated_limit, "limit on cells generated", 250);
+  addsaver(draw_threads, "draw threads", 1);
+  addsaver(retained_mode, "retained mode", false);
+  addsaver(retained_period, "retained mode period", 1000);
+  #if CAP_SDL
+  addsaver(softraster::on, "software rasterizer", false);
+  #endif
   
   #if CAP_SOLV
   addsaver(solnihv::solrange_xy, "solrange-xy");
@@ -697,8 +705,12 @@ EX void resetModes(char leave IS('c')) {
   start_game();
   }
 
+/** increased whenever a setting may have changed: by the dialog keys and editors, when the configuration is loaded or reset, and on a command line option */
+EX int settings_revision;
+
 #if CAP_CONFIG  
 EX void resetConfig() {
+  settings_revision++;
   dynamicval<int> rx(vid.xres, 0);
   dynamicval<int> ry(vid.yres, 0);
   dynamicval<int> rf(vid.fsize, 0);
@@ -766,6 +778,7 @@ EX void parseline(const string& str) {
   }
 
 EX void loadNewConfig(FILE *f) {
+  settings_revision++;
   for(auto& c: savers) allconfigs[c->name] = c;
   string rd;
   while(true) {
@@ -2279,6 +2292,10 @@ EX int read_config_args() {
   if(argis("-c")) { PHASE(1); shift(); conffile = argcs(); }
 // change the configuration from the command line
   else if(argis("-aa")) { PHASEFROM(2); shift(); vid.antialias = argi(); }
+  else if(argis("-retain")) { PHASEFROM(2); shift(); retained_mode = argi(); }
+  #if CAP_SDL
+  else if(argis("-softraster")) { PHASEFROM(2); shift(); softraster::on = argi(); }
+  #endif
   else if(argis("-lw")) { PHASEFROM(2); shift_arg_formula(vid.linewidth); }
   else if(argis("-wm")) { PHASEFROM(2); shift(); vid.wallmode = argi(); }
   else if(argis("-mm")) { PHASEFROM(2); shift(); vid.monmode = argi(); }
@@ -2301,6 +2318,14 @@ EX int read_config_args() {
     PHASEFROM(2);
     nofps = true;
     }
+  else if(argis("-gmatrix-probes")) {
+    PHASEFROM(2);
+    show_gmatrix_probes = true;
+    }
+  else if(argis("-text-stats")) {
+    PHASEFROM(2);
+    show_text_stats = true;
+    }
   else if(argis("-nohud")) {
     PHASEFROM(2);
     nohud = true;
@@ -2360,6 +2385,10 @@ EX int read_config_args() {
   else if(argis("-mrsv")) {
     PHASEFROM(2); shift(); reserve_limit = argi(); apply_memory_reserve();
     }
+  else if(argis("-membudget")) {
+    PHASEFROM(2); shift(); memory_budget = parse_memory_size(args());
+    if(memory_budget < 0) { printf("Invalid memory size: %s\n", argcs()); exit(1); }
+    }
   else if(argis("-yca")) {
     PHASEFROM(2); 
     shift_arg_formula(vid.yshift);
@@ -382,10 +382,10 @@ shifttable get_canonical(coord co) {
 struct hrmap_crystal : hrmap_standard {
   heptagon *getOrigin() override { return get_heptagon_at(c0, S7); }
 
-  map<heptagon*, coord> hcoords;
-  map<coord, heptagon*> heptagon_at;
+  hashtable<heptagon*, coord> hcoords;
+  hashtable<coord, heptagon*> heptagon_at;
   map<int, eLand> landmemo;
-  map<coord, eLand> landmemo4;
+  hashtable<coord, eLand> landmemo4;
   unordered_map<cell*, unordered_map<cell*, int>> distmemo;
   map<cell*, ldcoord> sgc;
   cell *camelot_center;
@@ -415,12 +415,12 @@ struct hrmap_crystal : hrmap_standard {
     }
 
   ~hrmap_crystal() {
-    clearfrom(getOrigin());
+    if(!bulk_release()) clearfrom(getOrigin());
     }
   
   heptagon *get_heptagon_at(coord c, int deg) {
-    if(heptagon_at.count(c)) return heptagon_at[c];
     heptagon*& h = heptagon_at[c];
+    if(h) return h;
     h = tailored_alloc<heptagon> (deg);
     h->alt = NULL;
     h->cdata = NULL;
@@ -1553,6 +1553,7 @@ void transform_crystal_to_euclid () {
   // clean hcoords and heptagon_at so that the map is not deleted when we delete m
   m->hcoords.clear();
   m->heptagon_at.clear();
+  swap(m->arena, e->arena);
   delete m;
 
   for(int i=0; i<isize(allmaps); i++) 
@@ -1621,6 +1622,7 @@ void transform_euclid_to_crystal () {
 
   spacemap.clear();
   ispacemap.clear();
+  swap(m->arena, e->arena);
   delete e;
 
   for(int i=0; i<isize(allmaps); i++) 
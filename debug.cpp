@@ -669,6 +669,12 @@ int read_cheat_args() {
   else if(argis("-testdistances")) {
     PHASE(3); shift(); test_distances(argi());
     }
+  else if(argis("-bfs-reuse")) {
+    shift(); bfs_reuse = argi();
+    }
+  else if(argis("-bfs-verify")) {
+    bfs_verify = true;
+    }
   else if(argis("-M")) {
     PHASE(3) cheat(); start_game(); if(WDIM == 3) { drawthemap(); bfs(); }
     shift(); eMonster m = readMonster(args());
@@ -746,6 +752,10 @@ int read_cheat_args() {
     PHASEFROM(2); 
     shift(); vid.cells_drawn_limit = argi();
     }
+  else if(argis("-draw-threads")) {
+    PHASEFROM(2); 
+    shift(); draw_threads = argi();
+    }
   else if(argis("-genlimit")) {
     PHASEFROM(2); 
     shift(); vid.cells_generated_limit = argi();
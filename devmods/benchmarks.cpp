@@ -0,0 +1,319 @@
+// Benchmarks of the engine: map generation, bfs, drawing, matrices, translation, and the Hypersian Rug.
+
+// Usage: add this module to a build, e.g. with `mymake devmods/benchmarks`, then
+
+// [executable] -bench-bfs 300 -exit
+// [executable] -bfs-reuse 1 -bench-bfs 300 -exit
+// [executable] -geo 4 -bench-rug 20000 -exit
+
+// Each -bench-* option takes one parameter: the number of repetitions, or the size of the test.
+// Run -bench-list to see all of them.
+
+#include "../hyper.h"
+
+namespace hr {
+
+namespace bench {
+
+/** the time used by f, in milliseconds */
+int timed(const reaction_t& f) {
+  int t0 = SDL_GetTicks();
+  f();
+  return int(SDL_GetTicks() - t0);
+  }
+
+/** in noGUI mode there is no screen, so pretend to have a Full HD one while f runs */
+void with_screen(const reaction_t& f) {
+  dynamicval<int> dx(vid.xres, vid.xres ? vid.xres : 1920);
+  dynamicval<int> dy(vid.yres, vid.yres ? vid.yres : 1080);
+  calcparam();
+  f();
+  ptds.clear();
+  }
+
+/** compare the cached and uncached hrmap_standard::relative_matrix on random pairs of cells in distance 10..40 */
+void relative_matrix(int qty) {
+  vector<pair<cell*, cell*>> pairs;
+  int attempts = 0;
+  while(isize(pairs) < qty && attempts++ < 100 * qty) {
+    cell *c1 = cwt.at;
+    for(int i=0; i<30; i++) c1 = c1->cmove(hrand(c1->type));
+    cell *c2 = c1;
+    int len = 10 + hrand(50);
+    for(int i=0; i<len; i++) c2 = c2->cmove(hrand(c2->type));
+    int d = celldistance(c1, c2);
+    if(d >= 10 && d <= 40) pairs.emplace_back(c1, c2);
+    }
+  println(hlog, "pairs: ", isize(pairs), " heptagons: ", heptacount);
+  if(pairs.empty()) return;
+
+  auto m = dynamic_cast<hrmap_standard*> (currentmap);
+  if(m) m->clear_relcache();
+
+  const char *names[3] = {"uncached: ", "chain cache: ", "memoized: "};
+  vector<transmatrix> results[3];
+  for(int cached: {0, 1, 2}) {
+    dynamicval<int> rc(relmatrix_cache, cached);
+    int reps = 0, total = 0;
+    while(total < 1000) {
+      total += timed([&] {
+        results[cached].clear();
+        for(auto& p: pairs) results[cached].push_back(calc_relative_matrix(p.second, p.first, C0));
+        });
+      reps++;
+      }
+    println(hlog, names[cached], total * 1e6 / reps / isize(pairs), " ns per call");
+    }
+
+  /* the matrices get huge for distant cells, so compare them relatively */
+  ld maxerr = 0;
+  for(int i=0; i<isize(pairs); i++)
+  for(int cached: {1, 2}) {
+    ld diff = 0, size = 0;
+    for(int a=0; a<MDIM; a++) for(int b=0; b<MDIM; b++) {
+      diff = max(diff, abs(results[0][i][a][b] - results[cached][i][a][b]));
+      size = max(size, abs(results[0][i][a][b]));
+      }
+    maxerr = max(maxerr, diff / size);
+    }
+  println(hlog, "max relative difference: ", maxerr);
+  }
+
+/** generate at least qty cells around the player in BFS order, and report the speed of generation */
+void generation(int qty) {
+  int cells0 = cellcount, hepta0 = heptacount;
+  int listed = 0;
+  int t = timed([&] { celllister cl(cwt.at, 1000000, qty, NULL); listed = isize(cl.lst); });
+  int generated = cellcount - cells0;
+  println(hlog, "listed: ", listed, " generated: ", generated, " cells, ", heptacount - hepta0, " heptagons in ", t, " ms");
+  if(t) println(hlog, "cells per second: ", generated * 1000. / t);
+  }
+
+/** walk qty random steps, and report the time used by bfs() after each step, and when called again without moving */
+void bfs(int qty) {
+  int moved = 0, waited = 0, cells = 0;
+  for(int i=0; i<qty; i++) {
+    cwt.at = cwt.at->cmove(hrand(cwt.at->type));
+    doOvergenerate();
+    moved += timed(hr::bfs);
+    // the traversal is reused only if the start directions drawn are the same, so wait several turns
+    waited += timed([] { for(int j=0; j<8; j++) hr::bfs(); });
+    cells += isize(dcal);
+    }
+  println(hlog, "bfs: ", qty, " steps, ", cells / max(qty, 1), " cells on average, ", moved, " ms after moving, ", waited / 8, " ms without moving");
+  }
+
+/** run qty shmup turns of 20 ms each, and report the speed */
+void turn(int qty) {
+  dynamicval<int> cm(cmode, sm::NORMAL);
+  int t = timed([&] { for(int i=0; i<qty; i++) shmup::turn(20); });
+  println(hlog, "turns: ", qty, " in ", t, " ms, monsters stored: ", isize(shmup::monstersAt));
+  if(t) println(hlog, "turns per second: ", qty * 1000. / t);
+  }
+
+/** micro-benchmarks of the basic matrix operations, on random isometries of the current geometry */
+void matrix(int qty) {
+  int N = 1000;
+  vector<transmatrix> in(N), out(N);
+  vector<hyperpoint> pts(N);
+  for(int i=0; i<N; i++) {
+    in[i] = spin(hrandf() * 2 * M_PI) * xpush(hrandf()) * spin(hrandf() * 2 * M_PI);
+    pts[i] = tC0(in[i]);
+    }
+  ld total = 0;
+  auto measure = [&] (const string& name, const reaction_t& f) {
+    int t = timed([&] { for(int i=0; i<qty; i++) f(); });
+    for(auto& T: out) total += T[0][0];
+    println(hlog, name, ": ", t * 1e6 / qty / N, " ns");
+    };
+  measure("copy", [&] { for(int i=0; i<N; i++) out[i] = in[i]; });
+  measure("inverse", [&] { for(int i=0; i<N; i++) out[i] = inverse(in[i]); });
+  measure("iso_inverse", [&] { for(int i=0; i<N; i++) out[i] = iso_inverse(in[i]); });
+  measure("T * U", [&] { for(int i=0; i<N; i++) out[i] = in[i] * in[N-1-i]; });
+  measure("T * h", [&] { for(int i=0; i<N; i++) out[i][0] = in[i] * pts[N-1-i]; });
+  measure("gpushxto0", [&] { for(int i=0; i<N; i++) out[i] = gpushxto0(pts[i]); });
+  measure("rspintox", [&] { for(int i=0; i<N; i++) out[i] = rspintox(pts[i]); });
+  println(hlog, "checksum: ", total);
+  }
+
+/** compare applymodel called per point with applymodel_batch, for each model which has a batch kernel */
+void applymodel(int qty) {
+  vector<hyperpoint> in(10000), out(10000);
+  for(auto& h: in) h = spin(hrandf() * 2 * M_PI) * xpush0(hrandf() * 5);
+  vector<pair<eModel, string>> models = {
+    {mdDisk, "disk"}, {mdHalfplane, "half-plane"}, {mdBand, "band"}, {mdEquidistant, "equidistant"},
+    {mdEquiarea, "equi-area"}, {mdHyperboloid, "hyperboloid"}, {mdHyperboloidFlat, "flat hyperboloid"}
+    };
+  for(auto& p: models) {
+    dynamicval<eModel> pm(pmodel, p.first);
+    if(!applymodel_batch_available()) continue;
+    int t1 = timed([&] { for(int i=0; i<qty; i++) for(int j=0; j<isize(in); j++) hr::applymodel(in[j], out[j]); });
+    int t2 = timed([&] { for(int i=0; i<qty; i++) applymodel_batch(in.data(), out.data(), isize(in)); });
+    println(hlog, p.second, ": ", t1, " ms unbatched, ", t2, " ms batched");
+    }
+  }
+
+/** time drawthemap, without the actual rendering */
+void draw(int qty) {
+  with_screen([&] {
+    int t = timed([&] { for(int i=0; i<qty; i++) { ptds.clear(); calcparam(); drawthemap(); } });
+    println(hlog, "cells drawn: ", cells_drawn, " shapes: ", isize(ptds), " time: ", t * 1. / qty, " ms per frame");
+    });
+  }
+
+#if CAP_SDL
+/** draw the current view into an offscreen surface, with SDL_gfx and with the software rasterizer, and report the time used by drawqueue */
+void softraster(int qty) {
+  dynamicval<bool> dg(vid.usingGL, false);
+  with_screen([&] {
+    SDL_Surface *srf = SDL_CreateRGBSurface(SDL_SWSURFACE, vid.xres, vid.yres, 32, 0xff0000, 0xff00, 0xff, 0xff000000);
+    if(!srf) return;
+    dynamicval<SDL_Surface*> ds(s, srf);
+    drawthemap();
+    for(bool on: {false, true}) {
+      dynamicval<bool> dsr(softraster::on, on);
+      int t = timed([&] { for(int i=0; i<qty; i++) drawqueue(); });
+      println(hlog, on ? "software rasterizer" : "SDL_gfx", ", threads: ", draw_threads, " shapes: ", isize(ptds), " time: ", t * 1. / qty, " ms per frame");
+      }
+    SDL_FreeSurface(srf);
+    });
+  }
+#endif
+
+/** draw frames while rotating the view, with and without retained mode, and report the time used by drawthemap */
+void retained(int qty) {
+  dynamicval<int> dt(ticks, ticks);
+  with_screen([&] {
+    for(bool on: {false, true}) {
+      dynamicval<bool> dr(retained_mode, on);
+      dynamicval<transmatrix> dv(View, View);
+      long long shapes = 0;
+      int t = timed([&] {
+        for(int i=0; i<qty; i++) {
+          View = spin(.01) * View;
+          ticks += 16;
+          ptds.clear();
+          drawthemap();
+          shapes += isize(ptds);
+          }
+        });
+      println(hlog, on ? "retained" : "immediate", ": cells drawn: ", cells_drawn, " shapes: ", shapes * 1. / qty, " time: ", t * 1. / qty, " ms per frame");
+      }
+    });
+  }
+
+/** record the draw queue of the current view, replay it in queues of various sizes, and report the time used by sort_drawqueue */
+void drawqueue(int qty) {
+  struct recorded { PPR prio; color_t color, outline; int subprio; };
+  vector<recorded> rec;
+  ptds.clear();
+  calcparam();
+  drawthemap();
+  for(auto& p: ptds) rec.push_back(recorded{p->prio, p->color, p->outline_group(), p->subprio});
+  ptds.clear();
+  println(hlog, "recorded: ", isize(rec), " items");
+  if(rec.empty()) return;
+  for(int size: {1000, 10000, 100000, 1000000}) {
+    int total = 0;
+    for(int i=0; i<qty; i++) {
+      for(int j=0; j<size; j++) {
+        auto& r = rec[j % isize(rec)];
+        auto& p = queuea<dqi_poly> (r.prio);
+        p.color = r.color; p.outline = r.outline; p.subprio = r.subprio;
+        }
+      total += timed(sort_drawqueue);
+      ptds.clear();
+      }
+    println(hlog, "size ", size, ": ", total * 1. / qty, " ms per sort");
+    }
+  }
+
+/** translate the item and monster help texts in every language, with and without the XLAT cache */
+void xlat(int qty) {
+  dynamicval<int> dl(vid.language, vid.language);
+  for(int limit: {0, 4096}) {
+    dynamicval<int> dc(xlat_cache_limit, limit);
+    xlat_cache_lookups = xlat_cache_hits = 0;
+    int total = 0;
+    int t = timed([&] {
+      for(int i=0; i<qty; i++) for(int l=0; l<NUMLAN; l++) {
+        vid.language = l;
+        for(int it=1; it<ittypes; it++) total += generateHelpForItem(eItem(it)).size();
+        for(int m=1; m<motypes; m++) total += generateHelpForMonster(eMonster(m)).size();
+        }
+      });
+    println(hlog, limit ? "cached" : "uncached", ": ", t, " ms, ", total, " characters, hits: ", xlat_cache_hits, "/", xlat_cache_lookups);
+    }
+  }
+
+#if CAP_RUG
+/** build the Hypersian Rug model of the current view with the given vertex limit, and report the time used */
+void rug(int qty) {
+  dynamicval<int> dv(rug::vertex_limit, qty);
+  dynamicval<int> dd(rug::rugdim, 2 * GDIM - 1);
+  int t = timed(rug::init_model);
+  println(hlog, "rug: ", isize(rug::points), " points, ", isize(rug::triangles), " triangles in ", t, " ms");
+  rug::clear_model();
+  }
+
+/** build the Hypersian Rug model of the current view, run its physics for qty frames with each solver,
+ *  and report the total error every 200 frames (one second of the 5 ms physics budget)
+ */
+void rug_physics(int qty) {
+  dynamicval<int> dd(rug::rugdim, 2 * GDIM - 1);
+  for(bool jacobi: {false, true}) {
+    dynamicval<bool> dj(rug::jacobi_physics, jacobi);
+    rug::init_model();
+    int t = 0;
+    for(int i=1; i<=qty; i++) {
+      t += timed(rug::physics);
+      if(i % 200 == 0 || i == qty)
+        println(hlog, jacobi ? "jacobi" : "queue", ": ", t, " ms, points: ", rug::qvalid, "/", isize(rug::points), " total error: ", rug::total_error());
+      }
+    rug::clear_model();
+    }
+  }
+#endif
+
+vector<pair<string, function<void(int)>>> benchmarks = {
+  {"relmatrix", relative_matrix},
+  {"generation", generation},
+  {"bfs", bfs},
+  {"turn", turn},
+  {"matrix", matrix},
+  {"applymodel", applymodel},
+  {"draw", draw},
+  #if CAP_SDL
+  {"softraster", softraster},
+  #endif
+  {"retained", retained},
+  {"drawqueue", drawqueue},
+  {"xlat", xlat},
+  #if CAP_RUG
+  {"rug", rug},
+  {"rugphysics", rug_physics},
+  #endif
+  };
+
+int readArgs() {
+  using namespace arg;
+
+  if(0) ;
+  else if(argis("-bench-list")) {
+    for(auto& b: benchmarks) println(hlog, "-bench-", b.first, " <n>");
+    }
+  else {
+    for(auto& b: benchmarks) if(argis("-bench-" + b.first)) {
+      PHASE(3); shift(); b.second(argi());
+      return 0;
+      }
+    return 1;
+    }
+  return 0;
+  }
+
+auto hook = addHook(hooks_args, 100, readArgs);
+
+}
+
+}
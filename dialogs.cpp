@@ -520,8 +520,11 @@ EX namespace dialog {
         if(isitem(items[i]))
           if(items[i].body == highlight_text) {
             uni = sym = items[i].key;
+            settings_revision++;
             return;
             }
+    /* a key of an item may change a setting; the other keys only navigate or pan */
+    for(auto& I: items) if(I.key && (I.key == uni || I.key == sym)) { settings_revision++; break; }
     if(DKEY == SDLK_PAGEDOWN) {
       for(int i=0; i<isize(items); i++)
         if(isitem(items[i]))
@@ -562,11 +565,13 @@ EX namespace dialog {
       uni = sym = 0;
       }
     if(key_actions.count(uni)) {
+      settings_revision++;
       key_actions[uni]();
       sym = uni = 0;
       return;
       }
     if(key_actions.count(sym)) {
+      settings_revision++;
       key_actions[sym]();
       sym = uni = 0;
       return;
@@ -588,6 +593,8 @@ EX namespace dialog {
   EX void handleKeyColor(int sym, int uni) {
     unsigned& color = *colorPointer;
     int shift = colorAlpha ? 0 : 8;
+    /* most keys change the color in place */
+    settings_revision++;
 
     if(uni >= 'A' && uni <= 'D') {
       int x = (mousex - (dcenter-dwidth/4)) * 510 / dwidth;
@@ -722,6 +729,7 @@ EX namespace dialog {
   EX reaction_t extra_options;
   
   EX void apply_slider() {
+    settings_revision++;
     if(ne.intval) *ne.intval = ldtoint(*ne.editwhat);
     if(reaction) reaction();
     if(ne.intval) *ne.editwhat = *ne.intval;
@@ -743,6 +751,7 @@ EX namespace dialog {
     if(!ep.ok()) return;
     if(ne.sc.positive && x <= 0) return;
     *ne.editwhat = x;
+    settings_revision++;
     if(ne.intval) *ne.intval = ldtoint(*ne.editwhat);
     #if CAP_ANIMATIONS
     if(ne.animatable) anims::animate_parameter(*ne.editwhat, ne.s, reaction ? reaction : reaction_final);    
@@ -91,11 +91,55 @@ struct dqi_circle : drawqueueitem {
 struct dqi_action : drawqueueitem {
   reaction_t action;
   dqi_action(const reaction_t& a) : action(a) {}
-  void draw() { action(); }
+  void draw();
   virtual color_t outline_group() { return 2; }
   };
+
+/** draw queue items are allocated by drawqueue_allocate, so they are only destructed rather than deleted */
+struct drawqueue_deleter { void operator() (drawqueueitem *p) const; };
+
+typedef unique_ptr<drawqueueitem, drawqueue_deleter> drawqueue_ptr;
 #endif
 
+/** a bump allocator for the draw queue items; it is rewound whenever all the items have been destructed,
+ *  so after the first few frames, queuing shapes does not call malloc at all
+ */
+struct drawqueue_arena {
+  static const int CHUNK = 1 << 18;
+  vector<char*> chunks;
+  /** the chunk we are allocating from, and the bytes used in it */
+  int current, used;
+  /** the number of items not yet destructed */
+  int live;
+  drawqueue_arena() { current = -1; used = CHUNK; live = 0; }
+  
+  void *allocate(size_t size) {
+    size = (size + 15) & ~15;
+    if(used + size > CHUNK) {
+      current++; used = 0;
+      if(current == isize(chunks)) chunks.push_back(new char[CHUNK]);
+      }
+    void *res = chunks[current] + used;
+    used += size;
+    live++;
+    return res;
+    }
+  
+  void release() {
+    live--;
+    if(!live) current = -1, used = CHUNK;
+    }
+  };
+
+drawqueue_arena dq_arena;
+
+EX void *drawqueue_allocate(size_t size) { return dq_arena.allocate(size); }
+
+void drawqueue_deleter::operator() (drawqueueitem *p) const {
+  p->~drawqueueitem();
+  dq_arena.release();
+  }
+
 EX unsigned char& part(color_t& col, int i) {
   unsigned char* c = (unsigned char*) &col;
 #if ISMOBILE
@@ -113,7 +157,7 @@ bool fatborder;
 
 EX color_t poly_outline;
 
-EX vector<unique_ptr<drawqueueitem>> ptds;
+EX vector<drawqueue_ptr> ptds;
 
 #if CAP_GL
 EX color_t text_color;
@@ -177,6 +221,8 @@ EX void glflush() {
 
     if(current_display->stereo_active() && text_shift && !svg::in) current_display->set_mask(0);
  
+    frame_texts_merged += texts_merged;
+    frame_text_batches++;
     texts_merged = 0;
     text_vertices.clear();
     }
@@ -355,6 +401,26 @@ void coords_to_poly() {
     }
   }
 
+vector<hyperpoint> batch_in, batch_out;
+
+/** addpoly for the case where nothing needs clipping: project all the points with one applymodel_batch call; returns false (doing nothing) if some point is behind the camera */
+bool addpoly_batch(const transmatrix& V, const vector<glvertex> &tab, int ofs, int cnt) {
+  batch_in.resize(cnt);
+  for(int i=0; i<cnt; i++) {
+    batch_in[i] = V * glhr::gltopoint(tab[ofs+i]);
+    if(is_behind(batch_in[i])) return false;
+    }
+  batch_out.resize(cnt);
+  applymodel_batch(batch_in.data(), batch_out.data(), cnt);
+  ld z = current_display->radius;
+  for(auto& Hscr: batch_out) {
+    for(int i=0; i<3; i++) Hscr[i] *= z;
+    Hscr[1] *= vid.stretch;
+    add1(Hscr);
+    }
+  return true;
+  }
+
 void addpoly(const transmatrix& V, const vector<glvertex> &tab, int ofs, int cnt) {
   if(pmodel == mdPixel) {
     for(int i=ofs; i<ofs+cnt; i++) {
@@ -366,6 +432,7 @@ void addpoly(const transmatrix& V, const vector<glvertex> &tab, int ofs, int cnt
     return;
     }
   tofix.clear(); knowgood = false;
+  if(!spherespecial && applymodel_batch_available() && addpoly_batch(V, tab, ofs, cnt)) return;
   hyperpoint last = V * glhr::gltopoint(tab[ofs]);
   bool last_behind = is_behind(last);
   if(!last_behind) addpoint(last);
@@ -416,16 +483,19 @@ void addpoly(const transmatrix& V, const vector<glvertex> &tab, int ofs, int cnt
 
 #if CAP_SDLGFX
 void aapolylineColor(SDL_Surface *s, int*x, int *y, int polyi, color_t col) {
+  if(softraster::collecting) { softraster::add_polyline(s, x, y, polyi, col, true); return; }
   for(int i=1; i<polyi; i++)
     aalineColor(s, x[i-1], y[i-1], x[i], y[i], col);
   }
 
 void polylineColor(SDL_Surface *s, int *x, int *y, int polyi, color_t col) {
+  if(softraster::collecting) { softraster::add_polyline(s, x, y, polyi, col, false); return; }
   for(int i=1; i<polyi; i++)
     lineColor(s, x[i-1], y[i-1], x[i], y[i], col);
   }
 
 EX void filledPolygonColorI(SDL_Surface *s, int* px, int *py, int polyi, color_t col) {
+  if(softraster::collecting) { softraster::add_fill(s, px, py, polyi, col); return; }
   std::vector<Sint16> spx(px, px + polyi);
   std::vector<Sint16> spy(py, py + polyi);
   filledPolygonColor(s, spx.data(), spy.data(), polyi, col);
@@ -434,6 +504,9 @@ EX void filledPolygonColorI(SDL_Surface *s, int* px, int *py, int polyi, color_t
 
 #if CAP_TEXTURE
 void drawTexturedTriangle(SDL_Surface *s, int *px, int *py, glvertex *tv, color_t col) {
+  #if CAP_SDL
+  if(softraster::collecting) { softraster::add_textured_triangle(s, px, py, tv, col); return; }
+  #endif
   transmatrix source = matrix3(
     px[0], px[1], px[2],
     py[0], py[1], py[2],
@@ -1668,6 +1741,9 @@ void dqi_line::draw() {
   }
 
 void dqi_string::draw() {
+  #if CAP_SDL
+  softraster::flush();
+  #endif
   #if CAP_SVG
   if(svg::in) {
     svg::text(x, y, size, str, frame, color, align);
@@ -1683,6 +1759,9 @@ void dqi_string::draw() {
   }
 
 void dqi_circle::draw() {
+  #if CAP_SDL
+  softraster::flush();
+  #endif
   #if CAP_SVG
   if(svg::in) {
     svg::circle(x, y, size, color, fillcolor, linewidth);
@@ -1691,6 +1770,13 @@ void dqi_circle::draw() {
   #endif
   drawCircle(x, y, size, color, fillcolor);
   }
+
+void dqi_action::draw() {
+  #if CAP_SDL
+  softraster::flush();
+  #endif
+  action();
+  }
         
 EX void initquickqueue() {
   ptds.clear();
@@ -1754,42 +1840,70 @@ void dqi_line::draw_back() {
   draw();
   }
 
+/** sort key of a draw queue item: major has the priority in bits 32..39, and the color (MINIMIZE_GL_CALLS) 
+ *  or the reversed subprio (transparent walls) in bits 0..31; minor is the outline group (MINIMIZE_GL_CALLS) */
+struct drawqueue_key {
+  unsigned long long major;
+  unsigned minor;
+  int id;
+  };
+
+vector<drawqueue_key> dq_keys, dq_keys2;
+
+/** one pass of the LSD radix sort; skipped if all the keys have the same digit */
+template<class T> void radix_pass(const T& digit) {
+  int cnt[256];
+  for(int i=0; i<256; i++) cnt[i] = 0;
+  for(auto& k: dq_keys) cnt[digit(k)]++;
+  for(int i=0; i<256; i++) if(cnt[i] == isize(dq_keys)) return;
+  int total = 0;
+  for(int i=0; i<256; i++) { int b = cnt[i]; cnt[i] = total; total += b; }
+  dq_keys2.resize(isize(dq_keys));
+  for(auto& k: dq_keys) dq_keys2[cnt[digit(k)]++] = k;
+  swap(dq_keys, dq_keys2);
+  }
+
 EX void sort_drawqueue() {
   
   for(int a=0; a<PMAX; a++) qp[a] = 0;
   
   int siz = isize(ptds);
 
-  #if MINIMIZE_GL_CALLS
-  unordered_map<color_t, vector<unique_ptr<drawqueueitem>>> subqueue;
-  for(auto& p: ptds) subqueue[(p->prio == PPR::CIRCLE || p->prio == PPR::OUTCIRCLE) ? 0 : p->outline_group()].push_back(move(p));
-  ptds.clear();
-  for(auto& p: subqueue) for(auto& r: p.second) ptds.push_back(move(r));
-  subqueue.clear();
-  for(auto& p: ptds) subqueue[(p->prio == PPR::CIRCLE || p->prio == PPR::OUTCIRCLE) ? 0 : p->color].push_back(move(p));
-  ptds.clear();
-  for(auto& p: subqueue) for(auto& r: p.second) ptds.push_back(move(r));
-  #endif
-    
-  for(auto& p: ptds) {
+  dq_keys.resize(siz);
+  for(int i=0; i<siz; i++) {
+    auto& p = ptds[i];
     int pd = p->prio - PPR::ZERO;
     if(pd < 0 || pd >= PMAX) {
       printf("Illegal priority %d\n", pd);
       p->prio = PPR(rand() % int(PPR::MAX));
+      pd = p->prio - PPR::ZERO;
       }
     qp[pd]++;
+    auto& k = dq_keys[i];
+    k.major = (unsigned long long) pd << 32;
+    k.minor = 0;
+    k.id = i;
+    if(p->prio == PPR::TRANSPARENT_WALL)
+      k.major |= ~(unsigned(p->subprio) ^ 0x80000000u);
+    #if MINIMIZE_GL_CALLS
+    else if(p->prio != PPR::CIRCLE && p->prio != PPR::OUTCIRCLE)
+      k.major |= p->color, k.minor = p->outline_group();
+    #endif
     }
   
+  for(int b=0; b<32; b+=8) radix_pass([b] (const drawqueue_key& k) { return (k.minor >> b) & 255; });
+  for(int b=0; b<40; b+=8) radix_pass([b] (const drawqueue_key& k) { return int((k.major >> b) & 255); });
+  
   int total = 0;
   for(int a=0; a<PMAX; a++) {
     int b = qp[a];
-    qp0[a] = qp[a] = total; total += b;
+    qp0[a] = total; total += b; qp[a] = total;
     }
 
-  vector<unique_ptr<drawqueueitem>> ptds2;  
+  vector<drawqueue_ptr> ptds2;  
   ptds2.resize(siz);
   
-  for(int i = 0; i<siz; i++) ptds2[qp[int(ptds[i]->prio)]++] = move(ptds[i]);
+  for(int i = 0; i<siz; i++) ptds2[i] = move(ptds[dq_keys[i].id]);
   swap(ptds, ptds2);
   }
 
@@ -1913,19 +2027,13 @@ EX void drawqueue() {
   for(PPR p: {PPR::REDWALLs, PPR::REDWALLs2, PPR::REDWALLs3, PPR::WALL3s,
     PPR::LAKEWALL, PPR::INLAKEWALL, PPR::BELOWBOTTOM}) 
   if(GDIM == 2) sort(&ptds[qp0[int(p)]], &ptds[qp[int(p)]], 
-    [] (const unique_ptr<drawqueueitem>& p1, const unique_ptr<drawqueueitem>& p2) {
+    [] (const drawqueue_ptr& p1, const drawqueue_ptr& p2) {
       auto ap1 = (dqi_poly&) *p1;
       auto ap2 = (dqi_poly&) *p2;
       return xintval(ap1.V * xpush0(.1))
         < xintval(ap2.V * xpush0(.1));
       });
 
-  for(PPR p: {PPR::TRANSPARENT_WALL})
-    sort(&ptds[qp0[int(p)]], &ptds[qp[int(p)]], 
-      [] (const unique_ptr<drawqueueitem>& p1, const unique_ptr<drawqueueitem>& p2) {
-        return p1->subprio > p2->subprio;
-        });
-
   profile_stop(3);
 
 #if CAP_SDL
@@ -1961,7 +2069,13 @@ EX void drawqueue() {
     global_projection = 0;
     }
   else {
+    #if CAP_SDL
+    softraster::begin();
+    #endif
     draw_main();
+    #if CAP_SDL
+    softraster::end();
+    #endif
     }    
 
 #if CAP_SDL
@@ -1993,7 +2107,7 @@ EX void drawqueue() {
 
 #if HDR
 template<class T, class... U> T& queuea(PPR prio, U... u) {
-  ptds.push_back(unique_ptr<T>(new T (u...)));
+  ptds.push_back(drawqueue_ptr(new (drawqueue_allocate(sizeof(T))) T (u...)));
   ptds.back()->prio = prio;  
   return (T&) *ptds.back();
   }
@@ -385,7 +385,7 @@ struct hrmap_torus : hrmap_euclid_any {
     }
   
   ~hrmap_torus() {
-    for(cell *c: all) tailored_delete(c);
+    if(!bulk_release()) for(cell *c: all) tailored_delete(c);
     }
 
   transmatrix relative_matrix(cell *c2, cell *c1, const hyperpoint& point_hint) {
@@ -432,7 +432,7 @@ struct hrmap_euclidean : hrmap_euclid_any {
       for(int y=0; y<256; y++) for(int x=0; x<256; x++)
         a[y][x] = NULL;
       }
-    ~euclideanSlab() {
+    void clear() {
       for(int y=0; y<256; y++) for(int x=0; x<256; x++)
         if(a[y][x]) tailored_delete(a[y][x]);
       }
@@ -463,7 +463,8 @@ struct hrmap_euclidean : hrmap_euclid_any {
   ~hrmap_euclidean() {
     for(int y=0; y<slabs; y++) for(int x=0; x<slabs; x++)
       if(euclidean[y][x]) { 
-        tailored_delete(euclidean[y][x]);
+        if(!bulk_release()) euclidean[y][x]->clear();
+        delete euclidean[y][x];
         euclidean[y][x] = NULL;
         }
     eucdata.clear();
@@ -602,8 +603,8 @@ EX namespace euclid3 {
   struct hrmap_euclid3 : hrmap {
     vector<coord> shifttable;
     vector<transmatrix> tmatrix;
-    map<coord, heptagon*> spacemap;
-    map<heptagon*, coord> ispacemap;
+    hashtable<coord, heptagon*> spacemap;
+    hashtable<heptagon*, coord> ispacemap;
     cell *camelot_center;
 
     vector<cell*> toruscells;  
@@ -633,8 +634,9 @@ EX namespace euclid3 {
       }
 
     heptagon *get_at(coord at) {
-      if(spacemap.count(at)) 
-        return spacemap[at];
+      auto it = spacemap.find(at);
+      if(it != spacemap.end()) 
+        return it->second;
       else {
         auto h = tailored_alloc<heptagon> (S7);
         h->c7 = newCell(S7, h);
@@ -764,8 +766,8 @@ EX namespace euclid3 {
     }
 
   EX vector<coord>& get_current_shifttable() { return cubemap()->shifttable; }
-  EX map<coord, heptagon*>& get_spacemap() { return cubemap()->spacemap; }
-  EX map<heptagon*, coord>& get_ispacemap() { return cubemap()->ispacemap; }
+  EX hashtable<coord, heptagon*>& get_spacemap() { return cubemap()->spacemap; }
+  EX hashtable<heptagon*, coord>& get_ispacemap() { return cubemap()->ispacemap; }
   EX cell *& get_camelot_center() { return cubemap()->camelot_center; }
 
   EX hrmap* new_map() {
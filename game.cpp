@@ -1065,6 +1065,17 @@ EX bool passable_for(eMonster m, cell *w, cell *from, flagtype extra) {
   return false;
   }
 
+/** movement groups with the same passability class have the same passable_for; 
+ *  this is moYeti for the groups for which passable_for is just passable, and the group itself otherwise
+ */
+EX eMonster passability_class(eMonster m) {
+  if(m == moWolf || isMagneticPole(m) || m == moPair || m == passive_switch) return m;
+  if(isWitch(m) || m == moEvilGolem) return m;
+  if(minf[m].mgroup == moYeti || isBug(m) || isDemon(m) || m == moHerdBull || m == moMimic || m == moAsteroid)
+    return moYeti;
+  return m;
+  }
+
 EX eMonster movegroup(eMonster m) { return minf[m].mgroup; }
 
 EX void useup(cell *c) {
@@ -3161,243 +3172,318 @@ EX void addButterfly(cell *c) {
   butterflies.push_back(make_pair(c, 0));
   }
 
-/** calculate cpdist, 'have' flags, and do general fixings */
-EX void bfs() {
+/** the part of bfs() which depends only on the player positions, the start directions, and the map */
+struct bfs_traversal {
+  vector<cell*> start;
+  /** the start directions, drawn with hrand for every call; the order of the traversal depends on them */
+  vector<int> dirs;
+  int cells, distlimit;
+  /** dcal and reachedfrom, as computed by the traversal */
+  vector<cell*> order;
+  vector<int> from;
+  /** the number of distinct player cells at the start of order */
+  int nstart;
+  /** the number of cells in order whose neighbors were examined */
+  int processed;
+  int first7;
+  /** HF_WARP and HF_MIRROR, if found by the traversal */
+  flagtype flags;
+  };
 
-  calcTidalPhase(); 
-    
-  yendor::onpath();
+/** the complete traversals computed for the current player positions, one for each combination of the start directions */
+vector<bfs_traversal> bfs_cache;
+
+/** bfs() reuses a previous traversal if the players have not moved, the start directions are the same, and no cells have been created or removed;
+ *  off by default (-bfs-reuse 1), since after a move, which is the common case, the traversal is still computed from scratch
+ */
+EX bool bfs_reuse = false;
+
+/** run bfs() from scratch too whenever a traversal could be reused, and check that the results agree (-bfs-verify) */
+EX bool bfs_verify = false;
+
+EX void invalidate_bfs() { bfs_cache.clear(); }
+
+/** the per-cell part of bfs(): remove treasures which can no longer be collected, and take note of monsters and terrain features */
+void bfs_visit(cell *c2, int distlimit) {
+  // remove treasures
+  if(!peace::on && c2->item && c2->cpdist == distlimit && itemclass(c2->item) == IC_TREASURE &&
+    c2->item != itBabyTortoise &&
+    (items[c2->item] >= (chaosmode?10:20) + currentLocalTreasure || getGhostcount() >= 2)) {
+      c2->item = itNone;
+      if(c2->land == laMinefield) { c2->landparam &= ~3; }
+      }
+      
+  if(c2->item == itBombEgg && c2->cpdist == distlimit && items[itBombEgg] >= c2->landparam) {
+    c2->item = itNone;
+    c2->landparam |= 2;
+    c2->landparam &= ~1;
+    if(!c2->monst) c2->monst = moBomberbird;
+    }
   
-  int dcs = isize(dcal);
-  for(int i=0; i<dcs; i++) dcal[i]->cpdist = INFD;
-  worms.clear(); ivies.clear(); ghosts.clear(); golems.clear(); 
-  tempmonsters.clear(); targets.clear(); 
-  statuecount = 0;
-  hexsnakes.clear(); 
+  if(c2->item == itBarrow && c2->cpdist == distlimit && c2->wall != waBarrowDig) {
+    c2->item = itNone;
+    }
+  
+  if(c2->item == itLotus && c2->cpdist == distlimit && items[itLotus] >= getHauntedDepth(c2)) {
+    c2->item = itNone;
+    }
+  
+  if(c2->item == itMutant2 && timerghost) {
+    bool rotten = true;
+    for(int i=0; i<c2->type; i++)
+      if(c2->move(i) && c2->move(i)->monst == moMutant)
+        rotten = false;
+    if(rotten) c2->item = itNone;
+    }
+  
+  if(c2->item == itDragon && (shmup::on ? shmup::curtime-c2->landparam>300000 : 
+    turncount-c2->landparam > 500))
+    c2->item = itNone;
 
-  hadwhat = havewhat;
-  havewhat = 0; jiangshi_on_screen = 0;
-  snaketypes.clear();
-  if(!(hadwhat & HF_WARP)) { avengers = 0; }
-  if(!(hadwhat & HF_MIRROR)) { mirrorspirits = 0; }
+  if(c2->item == itTrollEgg && c2->cpdist == distlimit && !shmup::on && c2->landparam && turncount-c2->landparam > 650)
+    c2->item = itNone;
 
-  elec::havecharge = false;
-  elec::afterOrb = false;
-  elec::haveelec = false;
-  airmap.clear();
-  if(!(hadwhat & HF_ROSE)) rosemap.clear();
+  if(c2->item == itWest && c2->cpdist == distlimit && items[itWest] >= c2->landparam + 4)
+    c2->item = itNone;
+
+  if(c2->item == itMutant && c2->cpdist == distlimit && items[itMutant] >= c2->landparam) {
+    c2->item = itNone;
+    }
+
+  if(c2->item == itIvory && c2->cpdist == distlimit && items[itIvory] >= c2->landparam) {
+    c2->item = itNone;
+    }
+  
+  if(c2->item == itAmethyst && c2->cpdist == distlimit && items[itAmethyst] >= -celldistAlt(c2)/5) {
+    c2->item = itNone;
+    }
   
+  if(!keepLightning) c2->ligon = 0;
+
+  if(c2->wall == waBigStatue && c2->land != laTemple) 
+    statuecount++;
+    
+  if(cellHalfvine(c2) && isWarped(c2)) {
+    addMessage(XLAT("%The1 is destroyed!", c2->wall));
+    destroyHalfvine(c2);
+    }
+  
+  if(c2->wall == waCharged) elec::havecharge = true;
+  if(c2->land == laStorms) elec::haveelec = true;
+  
+  if(c2->land == laWhirlpool) havewhat |= HF_WHIRLPOOL;
+  if(c2->land == laWhirlwind) havewhat |= HF_WHIRLWIND;
+  if(c2->land == laWestWall) havewhat |= HF_WESTWALL;
+  if(c2->land == laPrairie) havewhat |= HF_RIVER;
+
+  if(c2->wall == waRose) havewhat |= HF_ROSE;
+  
+  if((hadwhat & HF_ROSE) && (rosemap[c2] & 3)) havewhat |= HF_ROSE;
+  
+  if(c2->monst) {
+    if(isHaunted(c2->land) && 
+      c2->monst != moGhost && c2->monst != moZombie && c2->monst != moNecromancer)
+      survivalist = false;
+    if(c2->monst == moHexSnake || c2->monst == moHexSnakeTail) {
+      havewhat |= HF_HEX;
+      if(c2->mondir != NODIR)
+        snaketypes.insert(snake_pair(c2));
+      if(c2->monst == moHexSnake) hexsnakes.push_back(c2);
+      else findWormIvy(c2);
+      }
+    else if(c2->monst == moKrakenT || c2->monst == moKrakenH) {
+      havewhat |= HF_KRAKEN;
+      }
+    else if(c2->monst == moDragonHead || c2->monst == moDragonTail) {
+      havewhat |= HF_DRAGON;
+      }
+    else if(c2->monst == moWitchSpeed) 
+      havewhat |= HF_FAST;
+    else if(c2->monst == moMutant)
+      havewhat |= HF_MUTANT;
+    else if(c2->monst == moJiangshi)
+      jiangshi_on_screen++;
+    else if(c2->monst == moOutlaw)
+      havewhat |= HF_OUTLAW;
+    else if(isGhostMover(c2->monst))
+      ghosts.push_back(c2);
+    else if(isWorm(c2) || isIvy(c2)) findWormIvy(c2);
+    else if(isBug(c2)) {
+      havewhat |= HF_BUG;
+      targets.push_back(c2);
+      }
+    else if(isFriendly(c2)) {
+      if(c2->monst != moMouse && !markEmpathy(itOrbInvis) && !(isWatery(c2) && markEmpathy(itOrbFish)) &&
+        !c2->stuntime) targets.push_back(c2);
+      if(c2->monst == moGolem) golems.push_back(c2);
+      if(c2->monst == moFriendlyGhost) golems.push_back(c2);
+      if(c2->monst == moKnight) golems.push_back(c2);
+      if(c2->monst == moTameBomberbird) golems.push_back(c2);
+      if(c2->monst == moMouse) { golems.push_back(c2); havewhat |= HF_MOUSE; }
+      if(c2->monst == moPrincess || c2->monst == moPrincessArmed) golems.push_back(c2);
+      if(c2->monst == moIllusion) {
+        if(items[itOrbIllusion]) items[itOrbIllusion]--;
+        else c2->monst = moNone;
+        }
+      }
+    else if(c2->monst == moButterfly) {
+      addButterfly(c2);
+      }
+    else if(isAngryBird(c2->monst)) {
+      havewhat |= HF_BIRD;
+      if(c2->monst == moBat) havewhat |= HF_BATS | HF_EAGLES;
+      if(c2->monst == moEagle) havewhat |= HF_EAGLES;
+      }
+    else if(c2->monst == moReptile) havewhat |= HF_REPTILE;
+    else if(isLeader(c2->monst)) havewhat |= HF_LEADER;
+    else if(c2->monst == moEarthElemental) havewhat |= HF_EARTH;
+    else if(c2->monst == moWaterElemental) havewhat |= HF_WATER;
+    else if(c2->monst == moVoidBeast) havewhat |= HF_VOID;
+    else if(c2->monst == moHunterDog) havewhat |= HF_HUNTER;
+    else if(isMagneticPole(c2->monst)) havewhat |= HF_MAGNET;
+    else if(c2->monst == moAltDemon) havewhat |= HF_ALT;
+    else if(c2->monst == moHexDemon) havewhat |= HF_HEXD;
+    else if(c2->monst == moMonk) havewhat |= HF_MONK;
+    else if(c2->monst == moShark || c2->monst == moCShark) havewhat |= HF_SHARK;
+    else if(c2->monst == moAirElemental) 
+      havewhat |= HF_AIR, airmap.push_back(make_pair(c2,0));
+    }
+  // pheromones!
+  if(c2->land == laHive && c2->landparam >= 50 && c2->wall != waWaxWall) 
+    havewhat |= HF_BUG;
+  if(c2->wall == waThumperOn)
+    targets.push_back(c2);
+  }
+
+/** the traversal from scratch; computes cpdist, dcal and reachedfrom, but does not change the cells otherwise */
+void bfs_traverse(bfs_traversal& t) {
+  int dcs = isize(dcal);
+  for(int i=0; i<dcs; i++) dcal[i]->cpdist = INFD;
   dcal.clear(); reachedfrom.clear(); 
 
-  recalcTide = false;
-  
-  for(int i=0; i<numplayers(); i++) {
-    cell *c = playerpos(i);
-    if(!c) continue;
-    if(c->cpdist == 0) continue;
+  for(int i=0; i<isize(t.start); i++) {
+    cell *c = t.start[i];
     c->cpdist = 0;
-    checkTide(c);
     dcal.push_back(c);
-    reachedfrom.push_back(hrand(c->type));
-    if(!invismove) targets.push_back(c);
+    reachedfrom.push_back(t.dirs[i]);
     }
   
-  int distlimit = gamerange();
-
-  for(int i=0; i<numplayers(); i++) {
-    cell *c = playerpos(i);
-    if(!c) continue;
-    if(items[itOrbDomination])
-    if(c->monst == moTentacle || c->monst == moTentaclewait || c->monst == moTentacleEscaping)
-      worms.push_back(c);
-    }
+  bool complete = true;
+  t.flags = 0;
+  t.processed = 0;
   
   int qb = 0;
   first7 = 0;
   while(true) {
     if(qb == isize(dcal)) break;
-    int i, fd = reachedfrom[qb] + 3;
+    int fd = reachedfrom[qb] + 3;
     cell *c = dcal[qb++];
     
     int d = c->cpdist;
     
-    if(WDIM == 2 && d == distlimit) { first7 = qb; break; }
+    if(WDIM == 2 && d == t.distlimit) { first7 = qb; break; }
+    t.processed = qb;
 
-    for(int j=0; j<c->type; j++) if(i = (fd+j) % c->type, c->move(i)) {
-      // printf("i=%d cd=%d\n", i, c->move(i)->cpdist);
+    for(int j=0; j<c->type; j++) {
+      int i = (fd+j) % c->type;
       cell *c2 = c->move(i);
-      if(!c2) continue;
+      if(!c2) { complete = false; continue; }
       
-      if(isWarpedType(c2->land)) havewhat |= HF_WARP;
-      if(c2->land == laMirror) havewhat |= HF_MIRROR;
+      if(isWarpedType(c2->land)) t.flags |= HF_WARP;
+      if(c2->land == laMirror) t.flags |= HF_MIRROR;
       
-      if((c->wall == waBoat || c->wall == waSea) &&
-        (c2->wall == waSulphur || c2->wall == waSulphurC))
-        c2->wall = waSea;
-      
-      if(c2 && signed(c2->cpdist) > d+1) {
+      if(signed(c2->cpdist) > d+1) {
         if(WDIM == 3 && !gmatrix.count(c2)) {
           if(!first7) first7 = qb;
           continue;
           }
         c2->cpdist = d+1;
         
-        // remove treasures
-        if(!peace::on && c2->item && c2->cpdist == distlimit && itemclass(c2->item) == IC_TREASURE &&
-          c2->item != itBabyTortoise &&
-          (items[c2->item] >= (chaosmode?10:20) + currentLocalTreasure || getGhostcount() >= 2)) {
-            c2->item = itNone;
-            if(c2->land == laMinefield) { c2->landparam &= ~3; }
-            }
-            
-        if(c2->item == itBombEgg && c2->cpdist == distlimit && items[itBombEgg] >= c2->landparam) {
-          c2->item = itNone;
-          c2->landparam |= 2;
-          c2->landparam &= ~1;
-          if(!c2->monst) c2->monst = moBomberbird;
-          }
-        
-        if(c2->item == itBarrow && c2->cpdist == distlimit && c2->wall != waBarrowDig) {
-          c2->item = itNone;
-          }
-        
-        if(c2->item == itLotus && c2->cpdist == distlimit && items[itLotus] >= getHauntedDepth(c2)) {
-          c2->item = itNone;
-          }
-        
-        if(c2->item == itMutant2 && timerghost) {
-          bool rotten = true;
-          for(int i=0; i<c2->type; i++)
-            if(c2->move(i) && c2->move(i)->monst == moMutant)
-              rotten = false;
-          if(rotten) c2->item = itNone;
-          }
-        
-        if(c2->item == itDragon && (shmup::on ? shmup::curtime-c2->landparam>300000 : 
-          turncount-c2->landparam > 500))
-          c2->item = itNone;
-      
-        if(c2->item == itTrollEgg && c2->cpdist == distlimit && !shmup::on && c2->landparam && turncount-c2->landparam > 650)
-          c2->item = itNone;
-
-        if(c2->item == itWest && c2->cpdist == distlimit && items[itWest] >= c2->landparam + 4)
-          c2->item = itNone;
-      
-        if(c2->item == itMutant && c2->cpdist == distlimit && items[itMutant] >= c2->landparam) {
-          c2->item = itNone;
-          }
-      
-        if(c2->item == itIvory && c2->cpdist == distlimit && items[itIvory] >= c2->landparam) {
-          c2->item = itNone;
-          }
-        
-        if(c2->item == itAmethyst && c2->cpdist == distlimit && items[itAmethyst] >= -celldistAlt(c2)/5) {
-          c2->item = itNone;
-          }
-        
-        if(!keepLightning) c2->ligon = 0;
         dcal.push_back(c2);
         reachedfrom.push_back(c->c.spin(i));
-        
-        checkTide(c2);
-                
-        if(c2->wall == waBigStatue && c2->land != laTemple) 
-          statuecount++;
-          
-        if(cellHalfvine(c2) && isWarped(c2)) {
-          addMessage(XLAT("%The1 is destroyed!", c2->wall));
-          destroyHalfvine(c2);
-          }
-        
-        if(c2->wall == waCharged) elec::havecharge = true;
-        if(c2->land == laStorms) elec::haveelec = true;
-        
-        if(c2->land == laWhirlpool) havewhat |= HF_WHIRLPOOL;
-        if(c2->land == laWhirlwind) havewhat |= HF_WHIRLWIND;
-        if(c2->land == laWestWall) havewhat |= HF_WESTWALL;
-        if(c2->land == laPrairie) havewhat |= HF_RIVER;
-
-        if(c2->wall == waRose) havewhat |= HF_ROSE;
-        
-        if((hadwhat & HF_ROSE) && (rosemap[c2] & 3)) havewhat |= HF_ROSE;
-        
-        if(c2->monst) {
-          if(isHaunted(c2->land) && 
-            c2->monst != moGhost && c2->monst != moZombie && c2->monst != moNecromancer)
-            survivalist = false;
-          if(c2->monst == moHexSnake || c2->monst == moHexSnakeTail) {
-            havewhat |= HF_HEX;
-            if(c2->mondir != NODIR)
-              snaketypes.insert(snake_pair(c2));
-            if(c2->monst == moHexSnake) hexsnakes.push_back(c2);
-            else findWormIvy(c2);
-            }
-          else if(c2->monst == moKrakenT || c2->monst == moKrakenH) {
-            havewhat |= HF_KRAKEN;
-            }
-          else if(c2->monst == moDragonHead || c2->monst == moDragonTail) {
-            havewhat |= HF_DRAGON;
-            }
-          else if(c2->monst == moWitchSpeed) 
-            havewhat |= HF_FAST;
-          else if(c2->monst == moMutant)
-            havewhat |= HF_MUTANT;
-          else if(c2->monst == moJiangshi)
-            jiangshi_on_screen++;
-          else if(c2->monst == moOutlaw)
-            havewhat |= HF_OUTLAW;
-          else if(isGhostMover(c2->monst))
-            ghosts.push_back(c2);
-          else if(isWorm(c2) || isIvy(c2)) findWormIvy(c2);
-          else if(isBug(c2)) {
-            havewhat |= HF_BUG;
-            targets.push_back(c2);
-            }
-          else if(isFriendly(c2)) {
-            if(c2->monst != moMouse && !markEmpathy(itOrbInvis) && !(isWatery(c2) && markEmpathy(itOrbFish)) &&
-              !c2->stuntime) targets.push_back(c2);
-            if(c2->monst == moGolem) golems.push_back(c2);
-            if(c2->monst == moFriendlyGhost) golems.push_back(c2);
-            if(c2->monst == moKnight) golems.push_back(c2);
-            if(c2->monst == moTameBomberbird) golems.push_back(c2);
-            if(c2->monst == moMouse) { golems.push_back(c2); havewhat |= HF_MOUSE; }
-            if(c2->monst == moPrincess || c2->monst == moPrincessArmed) golems.push_back(c2);
-            if(c2->monst == moIllusion) {
-              if(items[itOrbIllusion]) items[itOrbIllusion]--;
-              else c2->monst = moNone;
-              }
-            }
-          else if(c2->monst == moButterfly) {
-            addButterfly(c2);
-            }
-          else if(isAngryBird(c2->monst)) {
-            havewhat |= HF_BIRD;
-            if(c2->monst == moBat) havewhat |= HF_BATS | HF_EAGLES;
-            if(c2->monst == moEagle) havewhat |= HF_EAGLES;
-            }
-          else if(c2->monst == moReptile) havewhat |= HF_REPTILE;
-          else if(isLeader(c2->monst)) havewhat |= HF_LEADER;
-          else if(c2->monst == moEarthElemental) havewhat |= HF_EARTH;
-          else if(c2->monst == moWaterElemental) havewhat |= HF_WATER;
-          else if(c2->monst == moVoidBeast) havewhat |= HF_VOID;
-          else if(c2->monst == moHunterDog) havewhat |= HF_HUNTER;
-          else if(isMagneticPole(c2->monst)) havewhat |= HF_MAGNET;
-          else if(c2->monst == moAltDemon) havewhat |= HF_ALT;
-          else if(c2->monst == moHexDemon) havewhat |= HF_HEXD;
-          else if(c2->monst == moMonk) havewhat |= HF_MONK;
-          else if(c2->monst == moShark || c2->monst == moCShark) havewhat |= HF_SHARK;
-          else if(c2->monst == moAirElemental) 
-            havewhat |= HF_AIR, airmap.push_back(make_pair(c2,0));
-          }
-        // pheromones!
-        if(c2->land == laHive && c2->landparam >= 50 && c2->wall != waWaxWall) 
-          havewhat |= HF_BUG;
-        if(c2->wall == waThumperOn)
-          targets.push_back(c2);
+        }
+      }
+    }
+  
+  t.nstart = isize(t.start);
+  t.first7 = first7;
+  if(complete && WDIM == 2 && bfs_reuse) {
+    t.order = dcal;
+    t.from = reachedfrom;
+    for(auto& t1: bfs_cache) if(t1.dirs == t.dirs) { t1 = t; return; }
+    if(isize(bfs_cache) >= 16) bfs_cache.clear();
+    bfs_cache.push_back(t);
+    }
+  }
 
+/** the rest of bfs(), in the order of the traversal t: the tides, sulphur turning into sea next to boats, and bfs_visit() for every cell */
+void bfs_replay(const bfs_traversal& t, int distlimit) {
+  for(int i=0; i<t.nstart; i++) {
+    cell *c = dcal[i];
+    checkTide(c);
+    if(!invismove) targets.push_back(c);
+    }
+  havewhat |= t.flags;
+  int next = t.nstart;
+  for(int qb=0; qb<t.processed; qb++) {
+    cell *c = dcal[qb];
+    int fd = reachedfrom[qb] + 3;
+    for(int j=0; j<c->type; j++) {
+      cell *c2 = c->move((fd+j) % c->type);
+      if(!c2) continue;
+      if((c->wall == waBoat || c->wall == waSea) &&
+        (c2->wall == waSulphur || c2->wall == waSulphurC))
+        c2->wall = waSea;
+      // the cells first reached from c come next in dcal
+      if(next < isize(dcal) && dcal[next] == c2) {
+        next++;
+        checkTide(c2);
+        bfs_visit(c2, distlimit);
         }
       }
     }
+  }
+
+/** one run of bfs() after the start directions have been drawn; reuses the traversal from bfs_cache if possible */
+void bfs_run(bfs_traversal& t, bool reuse) {
+  int distlimit = t.distlimit;
+  worms.clear(); ivies.clear(); ghosts.clear(); golems.clear(); 
+  tempmonsters.clear(); targets.clear(); 
+  statuecount = 0;
+  hexsnakes.clear(); 
+
+  havewhat = 0; jiangshi_on_screen = 0;
+  snaketypes.clear();
+  if(!(hadwhat & HF_WARP)) { avengers = 0; }
+  if(!(hadwhat & HF_MIRROR)) { mirrorspirits = 0; }
+
+  elec::havecharge = false;
+  elec::afterOrb = false;
+  elec::haveelec = false;
+  airmap.clear();
+  if(!(hadwhat & HF_ROSE)) rosemap.clear();
+  
+  recalcTide = false;
+  
+  for(cell *c: t.start) {
+    if(items[itOrbDomination])
+    if(c->monst == moTentacle || c->monst == moTentaclewait || c->monst == moTentacleEscaping)
+      worms.push_back(c);
+    }
+  
+  bfs_traversal *found = nullptr;
+  if(reuse) for(auto& t1: bfs_cache) if(t1.dirs == t.dirs) found = &t1;
+  
+  if(found) {
+    dcal = found->order;
+    reachedfrom = found->from;
+    first7 = found->first7;
+    bfs_replay(*found, distlimit);
+    }
+  else {
+    bfs_traverse(t);
+    bfs_replay(t, distlimit);
+    }
 
   while(recalcTide) {
     recalcTide = false;
@@ -3409,6 +3495,118 @@ EX void bfs() {
   buildAirmap();
   }
 
+/** what -bfs-verify compares */
+struct bfs_results {
+  vector<cell*> dcal, worms, ivies, ghosts, golems, targets, hexsnakes;
+  vector<int> reachedfrom, cpdist;
+  vector<pair<cell*, int>> airmap, butterflies;
+  set<int> snaketypes;
+  int first7, statuecount;
+  flagtype havewhat;
+  /** the cells in the range and their neighbors, after bfs() */
+  vector<gcell> cells;
+  };
+
+vector<cell*> bfs_affected() {
+  vector<cell*> res = dcal;
+  for(cell *c: dcal) forCellEx(c2, c) res.push_back(c2);
+  sort(res.begin(), res.end());
+  res.erase(unique(res.begin(), res.end()), res.end());
+  return res;
+  }
+
+bfs_results bfs_get_results(const vector<cell*>& affected) {
+  bfs_results r;
+  r.dcal = dcal; r.worms = worms; r.ivies = ivies; r.ghosts = ghosts; r.golems = golems; r.targets = targets; r.hexsnakes = hexsnakes;
+  r.reachedfrom = reachedfrom;
+  for(cell *c: dcal) r.cpdist.push_back(c->cpdist);
+  r.airmap = airmap; r.butterflies = butterflies;
+  r.snaketypes = snaketypes;
+  r.first7 = first7; r.statuecount = statuecount; r.havewhat = havewhat;
+  for(cell *c: affected) r.cells.push_back(*c);
+  return r;
+  }
+
+bool same_cell_contents(const gcell& a, const gcell& b) {
+  return a.wall == b.wall && a.item == b.item && a.monst == b.monst && a.land == b.land &&
+    a.landparam == b.landparam && a.wparam == b.wparam && a.mondir == b.mondir && a.ligon == b.ligon;
+  }
+
+bool operator == (const bfs_results& a, const bfs_results& b) {
+  if(!(a.dcal == b.dcal && a.worms == b.worms && a.ivies == b.ivies && a.ghosts == b.ghosts && a.golems == b.golems &&
+    a.targets == b.targets && a.hexsnakes == b.hexsnakes && a.reachedfrom == b.reachedfrom && a.cpdist == b.cpdist &&
+    a.airmap == b.airmap && a.butterflies == b.butterflies && a.snaketypes == b.snaketypes &&
+    a.first7 == b.first7 && a.statuecount == b.statuecount && a.havewhat == b.havewhat && isize(a.cells) == isize(b.cells)))
+    return false;
+  for(int i=0; i<isize(a.cells); i++) if(!same_cell_contents(a.cells[i], b.cells[i])) return false;
+  return true;
+  }
+
+/** calculate cpdist, 'have' flags, and do general fixings */
+EX void bfs() {
+
+  calcTidalPhase(); 
+    
+  yendor::onpath();
+  
+  bfs_traversal t;
+  t.distlimit = gamerange();
+  t.cells = cellcount;
+
+  for(int i=0; i<numplayers(); i++) {
+    cell *c = playerpos(i);
+    if(c && find(t.start.begin(), t.start.end(), c) == t.start.end()) t.start.push_back(c);
+    }
+  for(cell *c: t.start) t.dirs.push_back(hrand(c->type));
+  
+  if(!bfs_cache.empty()) {
+    auto& t1 = bfs_cache[0];
+    if(t1.start != t.start || t1.cells != t.cells || t1.distlimit != t.distlimit) bfs_cache.clear();
+    }
+  bool reuse = bfs_reuse && !bfs_cache.empty();
+  
+  hadwhat = havewhat;
+  
+  if(reuse && bfs_verify) {
+    // run the version which reuses the traversal, remember the results, restore the state, and compare with the full version
+    auto affected = bfs_affected();
+    vector<gcell> saved_cells;
+    for(cell *c: affected) saved_cells.push_back(*c);
+    auto saved_items = items;
+    auto saved_butterflies = butterflies;
+    auto saved_msgs = msgs;
+    auto saved_gamelog = gamelog;
+    bool saved_survivalist = survivalist;
+    int saved_avengers = avengers, saved_mirrorspirits = mirrorspirits;
+    auto saved_rosemap = rosemap;
+    
+    bfs_run(t, true);
+    auto reused = bfs_get_results(affected);
+    
+    for(int i=0; i<isize(affected); i++) (gcell&) *affected[i] = saved_cells[i];
+    items = saved_items;
+    butterflies = saved_butterflies;
+    msgs = saved_msgs;
+    gamelog = saved_gamelog;
+    survivalist = saved_survivalist;
+    avengers = saved_avengers; mirrorspirits = saved_mirrorspirits;
+    rosemap = saved_rosemap;
+    
+    bfs_run(t, false);
+    if(!(bfs_get_results(affected) == reused)) {
+      println(hlog, "bfs: the reused traversal does not agree with the full one");
+      exit(1);
+      }
+    }
+  else
+    bfs_run(t, reuse);
+  }
+
+auto bfs_hooks = 
+  addHook(clearmemory, 40, invalidate_bfs) + 
+  addHook(hooks_removecells, 0, invalidate_bfs) + 
+  addHook(hooks_gamedata, 0, [] (gamedata* gd) { gd->store(bfs_cache); });
+
 EX bool makeEmpty(cell *c) {
 
   if(c->monst != moPrincess) {
@@ -8039,6 +8237,8 @@ EX bool movepcto(int d, int subdir IS(1), bool checkonly IS(false)) {
 
   bool errormsgs = multi::players == 1 || multi::cpid == multi::players-1;
   if(hardcore && !canmove) return false;
+  // moving would generate new cells
+  if(memory_budget_exceeded && !ignored_memory_warning && d >= 0 && !checkonly) return false;
   if(!checkonly && d >= 0) {
     flipplayer = false;
     if(multi::players > 1) multi::flipped[multi::cpid] = false;
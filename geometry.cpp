@@ -977,6 +977,23 @@ EX void check_cgi() {
 
   }
 
+/** approximate memory used by the geometry_information structures in cgis, in bytes: the structures themselves and their largest tables */
+EX long long cgis_memory() {
+  long long res = 0;
+  for(auto& p: cgis) {
+    auto& g = p.second;
+    res += sizeof(geometry_information);
+    #if CAP_SHAPES
+    res += g.hpc.capacity() * sizeof(hyperpoint);
+    res += g.ourshape.capacity() * sizeof(glvertex);
+    res += g.walltester.capacity() * sizeof(hyperpoint);
+    res += g.raywall.capacity() * sizeof(transmatrix);
+    #endif
+    res += g.symmetriesAt.capacity() * sizeof(array<int, 3>);
+    }
+  return res;
+  }
+
 void clear_cgis() {
   printf("clear_cgis\n");
   for(auto& p: cgis) if(&p.second != &cgi) { cgis.erase(p.first); return; }
@@ -69,20 +69,158 @@ EX transmatrix calc_relative_matrix(cell *c2, cell *c1, const hyperpoint& point_
 namespace gp { extern gp::local_info draw_li; }
 #endif
 
+/** caching in hrmap_standard::relative_matrix: 0 = walk the tree and multiply every time, 1 = use cached chain products (see tree_relative_matrix), 2 = also memoize the results for pairs of cells */
+EX int relmatrix_cache = 2;
+
+/** the maximum number of heptagons in the relative_matrix cache of a map; the caches are cleared when this is exceeded */
+EX int relcache_limit = 16384;
+
+/** the product of heptmove along 2^lev steps up the move(0) chain from h, or its inverse */
+const transmatrix& hrmap_standard::chain_matrix(heptagon *h, int lev, bool inverse) {
+  if(lev == 0) {
+    int sp = h->c.spin(0);
+    return inverse ? cgi.invheptmove[sp] : cgi.heptmove[sp];
+    }
+  int id = h->c7->mapid;
+  if(id >= isize(relcache_index)) relcache_index.resize(id+1, -1);
+  int& ix = relcache_index[id];
+  if(ix == -1 || relcache[ix].h != h) {
+    ix = isize(relcache);
+    relcache.emplace_back();
+    relcache.back().h = h;
+    relcache.back().known = 0;
+    }
+  int i = ix;
+  if(!(relcache[i].known & (1<<lev))) {
+    heptagon *mid = h;
+    for(int k=0; k < (1<<(lev-1)); k++) mid = mid->move(0);
+    // the references returned are only valid until the next call, since it may reallocate relcache
+    transmatrix up = chain_matrix(mid, lev-1, false);
+    up = up * chain_matrix(h, lev-1, false);
+    transmatrix down = chain_matrix(h, lev-1, true);
+    down = down * chain_matrix(mid, lev-1, true);
+    auto& e = relcache[i];
+    e.up[lev-1] = up; e.down[lev-1] = down;
+    e.known |= (1<<lev);
+    }
+  return inverse ? relcache[i].down[lev-1] : relcache[i].up[lev-1];
+  }
+
+/** the product of heptmove along the given number of steps up the move(0) chain from h, or its inverse */
+transmatrix hrmap_standard::chain_product(heptagon *h, int steps, bool inverse) {
+  transmatrix T = Id;
+  bool first = true;
+  while(steps) {
+    int lev = 0;
+    // short chains are faster to multiply directly
+    if(h->c7 && steps >= 4) while(lev < RELCACHE_LEVELS && (2<<lev) <= steps) lev++;
+    if(first) T = chain_matrix(h, lev, inverse), first = false;
+    else if(inverse) T = T * chain_matrix(h, lev, true);
+    else T = chain_matrix(h, lev, false) * T;
+    for(int k=0; k < (1<<lev); k++) h = h->move(0);
+    steps -= (1<<lev);
+    }
+  return T;
+  }
+
+void hrmap_standard::clear_relcache() {
+  relcache.clear();
+  relcache_index.clear();
+  relmemo.clear();
+  relcache_cgi = &cgi;
+  }
+
+/** relative_matrix for unbounded maps where the heptagons form a tree via move(0).
+ *
+ *  The heptagons are walked exactly as in the uncached algorithm, but only the
+ *  number of steps on each side is recorded; the matrices are then obtained as
+ *  O(log steps) products of cached chain_matrix values.
+ */
+transmatrix hrmap_standard::tree_relative_matrix(heptagon *h2, transmatrix where, heptagon *h1, transmatrix gm) {
+  heptagon *start1 = h1, *start2 = h2;
+  int steps1 = 0, steps2 = 0;
+  while(h1 != h2) {
+    if(steps1 + steps2 > 10000) {
+      println(hlog, "not found"); return Id; 
+      }
+    for(int d=0; d<S7; d++) if(h2->move(d) == h1) {
+      int sp = h2->c.spin(d);
+      return gm * chain_product(start1, steps1, true) * cgi.heptmove[sp] * spin(2*M_PI*d/S7) * chain_product(start2, steps2, false) * where;
+      }
+    if(h1->distance < h2->distance) h2 = h2->move(0), steps2++;
+    else h1 = h1->move(0), steps1++;
+    }
+  return gm * chain_product(start1, steps1, true) * chain_product(start2, steps2, false) * where;
+  }
+
+#if CAP_CRYSTAL
+/** in crystal geometries, we move towards c1 in the crystal space, rather than up the tree */
+transmatrix crystal_relative_matrix(heptagon *h2, transmatrix where, heptagon *h1, transmatrix gm, cell *c1) {
+  set<heptagon*> visited;
+  map<ld, vector<pair<heptagon*, transmatrix>>> hbdist;
+
+  int steps = 0;
+  while(h1 != h2) {
+    steps++; if(steps > 10000) {
+      println(hlog, "not found"); return Id; 
+      }
+    for(int d=0; d<S7; d++) if(h2->move(d) == h1) {
+      int sp = h2->c.spin(d);
+      return gm * cgi.heptmove[sp] * spin(2*M_PI*d/S7) * where;
+      }
+    for(int d3=0; d3<S7; d3++) {
+      auto h3 = h2->cmove(d3);
+      if(visited.count(h3)) continue;
+      visited.insert(h3);
+      int sp3 = h2->c.spin(d3);
+      transmatrix where3 = cgi.heptmove[sp3] * spin(2*M_PI*d3/S7) * where;
+      ld dist = crystal::space_distance(h3->c7, c1);
+      hbdist[dist].emplace_back(h3, where3);
+      }
+    auto &bestv = hbdist.begin()->second;
+    tie(h2, where) = bestv.back();
+    bestv.pop_back();
+    if(bestv.empty()) hbdist.erase(hbdist.begin());
+    }
+  return gm * where;
+  }
+#endif
+
 transmatrix hrmap_standard::relative_matrix(cell *c2, cell *c1, const hyperpoint& point_hint) {
 
   heptagon *h1 = c1->master;
-  transmatrix gm = master_relative(c1, true);
   heptagon *h2 = c2->master;
+
+  bool quotient_field = among(geometry, gFieldQuotient, gBring, gMacbeath);
+  bool use_tree = relmatrix_cache && !bounded && !quotient_field && !cryst;
+  relmemo_entry *memo = nullptr;
+  if(use_tree) {
+    if(relcache_cgi != &cgi || isize(relcache) > relcache_limit) clear_relcache();
+    if(relmatrix_cache >= 2) {
+      if(relmemo.empty()) relmemo.resize(RELMEMO_SIZE, relmemo_entry{-1, -1, Id});
+      unsigned hash = unsigned(c1->mapid) * 0x9E3779B1u ^ unsigned(c2->mapid) * 0x85EBCA6Bu;
+      memo = &relmemo[(hash ^ (hash >> 16)) & (RELMEMO_SIZE-1)];
+      if(memo->id1 == c1->mapid && memo->id2 == c2->mapid) return memo->T;
+      }
+    }
+
+  transmatrix gm = master_relative(c1, true);
   transmatrix where = master_relative(c2);
 
+  #if CAP_CRYSTAL
+  if(cryst) return crystal_relative_matrix(h2, where, h1, gm, c1);
+  #endif
+
+  if(use_tree) {
+    transmatrix T = tree_relative_matrix(h2, where, h1, gm);
+    if(memo) memo->id1 = c1->mapid, memo->id2 = c2->mapid, memo->T = T;
+    return T;
+    }
+
   // always add to last!
 //bool hsol = false;
 //transmatrix sol;
 
-  set<heptagon*> visited;
-  map<ld, vector<pair<heptagon*, transmatrix>>> hbdist;
-
   int steps = 0;
   while(h1 != h2) {
     steps++; if(steps > 10000) {
@@ -113,7 +251,7 @@ transmatrix hrmap_standard::relative_matrix(cell *c2, cell *c1, const hyperpoint
       int sp = h2->c.spin(d);
       return gm * cgi.heptmove[sp] * spin(2*M_PI*d/S7) * where;
       }
-    if(among(geometry, gFieldQuotient, gBring, gMacbeath)) {
+    if(quotient_field) {
       int bestdist = 1000000, bestd = 0;
       for(int d=0; d<S7; d++) {
         int dist = celldistance(h2->cmove(d)->c7, c1);
@@ -123,23 +261,6 @@ transmatrix hrmap_standard::relative_matrix(cell *c2, cell *c1, const hyperpoint
       where = cgi.heptmove[sp] * spin(2*M_PI*bestd/S7) * where;
       h2 = h2->move(bestd);
       }
-    #if CAP_CRYSTAL
-    else if(cryst) {
-      for(int d3=0; d3<S7; d3++) {
-        auto h3 = h2->cmove(d3);
-        if(visited.count(h3)) continue;
-        visited.insert(h3);
-        int sp3 = h2->c.spin(d3);
-        transmatrix where3 = cgi.heptmove[sp3] * spin(2*M_PI*d3/S7) * where;
-        ld dist = crystal::space_distance(h3->c7, c1);
-        hbdist[dist].emplace_back(h3, where3);
-        }
-      auto &bestv = hbdist.begin()->second;
-      tie(h2, where) = bestv.back();
-      bestv.pop_back();
-      if(bestv.empty()) hbdist.erase(hbdist.begin());
-      }
-    #endif
     else if(h1->distance < h2->distance) {
       int sp = h2->c.spin(0);
       h2 = h2->move(0);
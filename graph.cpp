@@ -393,7 +393,7 @@ EX void drawPlayerEffects(const transmatrix& V, cell *c, bool onplayer) {
 #if CAP_SHAPES
       transmatrix Vsword = 
         shmup::on ? V * shmup::swordmatrix[multi::cpid] * cspin(2, 0, M_PI/2) 
-                  : gmatrix[c] * rgpushxto0(inverse(gmatrix[c]) * tC0(V)) * sword::dir[multi::cpid].T;
+                  : gmatrix[c] * rgpushxto0(iso_inverse(gmatrix[c]) * tC0(V)) * sword::dir[multi::cpid].T;
 
       if(items[itOrbSword])
         queuepoly(Vsword * cspin(1,2, ticks / 150.), (peace::on ? cgi.shMagicShovel : cgi.shMagicSword), darkena(iinf[itOrbSword].color, 0, 0xC0 + 0x30 * sintick(200)));
@@ -408,7 +408,7 @@ EX void drawPlayerEffects(const transmatrix& V, cell *c, bool onplayer) {
       ang %= sword::sword_angles;
 
 #if CAP_QUEUE || CAP_SHAPES
-      transmatrix Vnow = gmatrix[c] * rgpushxto0(inverse(gmatrix[c]) * tC0(V)) * ddspin(c,0,M_PI); // (IRREGULAR ? ddspin(c,0,M_PI) : spin(-hexshiftat(c)));
+      transmatrix Vnow = gmatrix[c] * rgpushxto0(iso_inverse(gmatrix[c]) * tC0(V)) * ddspin(c,0,M_PI); // (IRREGULAR ? ddspin(c,0,M_PI) : spin(-hexshiftat(c)));
 #endif
 
       int adj = 1 - ((sword_angles/cwt.at->type)&1);
@@ -2257,7 +2257,7 @@ EX bool applyAnimation(cell *c, transmatrix& V, double& footphase, int layer) {
   
   if(sl2) {
     a.wherenow = slr::translate(tC0(a.wherenow));
-    hyperpoint h = tC0(inverse(a.wherenow));
+    hyperpoint h = tC0(iso_inverse(a.wherenow));
     hyperpoint ie = slr::get_inverse_exp(h, 0);
     auto R = hypot_d(3, ie);
     aspd *= (1+R+(shmup::on?1:0));
@@ -2288,9 +2288,9 @@ EX bool applyAnimation(cell *c, transmatrix& V, double& footphase, int layer) {
   else {
     hyperpoint wnow;
     if(a.attacking == 1)
-      wnow = tC0(inverse(a.wherenow) * a.attackat);
+      wnow = tC0(iso_inverse(a.wherenow) * a.attackat);
     else
-      wnow = tC0(inverse(a.wherenow));
+      wnow = tC0(iso_inverse(a.wherenow));
     
     if(prod) {
       auto d = product_decompose(wnow);
@@ -2473,7 +2473,7 @@ EX bool drawMonster(const transmatrix& Vparam, int ct, cell *c, color_t col, boo
           }
         else {
           if(c->monst == moTentacleGhost) {
-            hyperpoint V0 = history::on ? tC0(Vs) : inverse(cwtV) * tC0(Vs);
+            hyperpoint V0 = history::on ? tC0(Vs) : iso_inverse(cwtV) * tC0(Vs);
             hyperpoint V1 = spintox(V0) * V0;
             Vs = cwtV * rspintox(V0) * rpushxto0(V1) * pispin;
             drawMonsterType(moGhost, c, Vs, col, footphase, asciicol);
@@ -2666,7 +2666,7 @@ EX bool drawMonster(const transmatrix& Vparam, int ct, cell *c, color_t col, boo
       if(inmirrorcount&1) mirr = !mirr;
       col = mirrorcolor(geometry == gElliptic ? det(Vs) < 0 : mirr);
       if(!mouseout() && !nospins && GDIM == 2) {
-        hyperpoint P2 = Vs * inverse(cwtV) * mouseh;
+        hyperpoint P2 = Vs * iso_inverse(cwtV) * mouseh;
         queuechr(P2, 10, 'x', 0xFF00);
         }     
       if(!nospins && flipplayer) Vs = Vs * pispin;
@@ -2715,7 +2715,7 @@ EX bool drawMonster(const transmatrix& Vparam, int ct, cell *c, color_t col, boo
       }
     else if(NONSTDVAR) {
       transmatrix T = calc_relative_matrix(c->move(c->mondir), c, c->mondir);
-      Vb = Vb * T * rspintox(tC0(inverse(T))) * xpush(cgi.tentacle_length);
+      Vb = Vb * T * rspintox(tC0(iso_inverse(T))) * xpush(cgi.tentacle_length);
       }
     else {
       Vb = Vb * ddspin(c, c->mondir, M_PI);
@@ -2745,7 +2745,7 @@ EX bool drawMonster(const transmatrix& Vparam, int ct, cell *c, color_t col, boo
     
     if(!nospins) {
       if(WDIM == 2 || prod) {
-        hyperpoint V0 = inverse(cwtV) * tC0(Vs);
+        hyperpoint V0 = iso_inverse(cwtV) * tC0(Vs);
         ld z = 0;
         if(prod) {
           auto d = product_decompose(V0);
@@ -2761,7 +2761,7 @@ EX bool drawMonster(const transmatrix& Vparam, int ct, cell *c, color_t col, boo
           }
         }
       else if(!sl2) {
-        hyperpoint V0 = inverse(cwtV) * tC0(Vs);
+        hyperpoint V0 = iso_inverse(cwtV) * tC0(Vs);
         Vs = cwtV * rspintox(V0) * xpush(hdist0(V0)) * cspin(0, 2, -M_PI);
         // cwtV * rgpushxto0(inverse(cwtV) * tC0(Vs));
         }
@@ -4160,7 +4160,7 @@ EX void drawMarkers() {
         if(!c2) break;
         transmatrix T1 = ggmatrix(c1);
         transmatrix T2 = ggmatrix(c2);
-        transmatrix T = T1 * rspintox(inverse(T1)*T2*C0) * xpush(hdist(T1*C0, T2*C0) * fractick(50, 0));
+        transmatrix T = T1 * rspintox(iso_inverse(T1)*T2*C0) * xpush(hdist(T1*C0, T2*C0) * fractick(50, 0));
         color_t aircol = (orbToTarget == itOrbAir ? 0x8080FF40 : 0x8080FF20);
         queuepoly(T, cgi.shDisk, aircol);
         c1 = c2;
@@ -4377,7 +4377,7 @@ EX void precise_mouseover() {
   for(int loop = 0; loop < 10; loop++) { 
     bool found = false;
     if(!gmatrix.count(mouseover)) return;
-    hyperpoint r_mouseh = inverse(gmatrix[mouseover]) * mouseh;
+    hyperpoint r_mouseh = iso_inverse(gmatrix[mouseover]) * mouseh;
     for(int i=0; i<mouseover->type; i++) {
       hyperpoint h1 = get_corner_position(mouseover, (i+mouseover->type-1) % mouseover->type);
       hyperpoint h2 = get_corner_position(mouseover, i);
@@ -4417,6 +4417,12 @@ EX void drawthemap() {
   callhooks(hooks_drawmap);
 
   frameid++;
+  last_gmatrix_probes = gmatrix_probes; gmatrix_probes = 0;
+  last_gmatrix_found = gmatrix_found; gmatrix_found = 0;
+  last_text_cache_lookups = text_cache_lookups; text_cache_lookups = 0;
+  last_text_cache_hits = text_cache_hits; text_cache_hits = 0;
+  last_texts_merged = frame_texts_merged; frame_texts_merged = 0;
+  last_text_batches = frame_text_batches; frame_text_batches = 0;
   cells_drawn = 0;
   cells_generated = 0;
   noclipped = 0;
@@ -5107,7 +5113,7 @@ EX bool compute_relamatrix(cell *src, cell *tgt, int direction_hint, transmatrix
     }
   else {
     if(gmatrix.count(src) && gmatrix.count(tgt))
-      T = inverse(gmatrix[tgt]) * gmatrix[src];
+      T = iso_inverse(gmatrix[tgt]) * gmatrix[src];
     else
       return false;
     }
@@ -5145,7 +5151,7 @@ EX void animateAttack(cell *src, cell *tgt, int layer, int direction_hint) {
   bool newanim = !animations[layer].count(src);
   animation& a = animations[layer][src];
   a.attacking = 1;
-  a.attackat = rspintox(tC0(inverse(T))) * xpush(hdist0(T*C0) / 3);
+  a.attackat = rspintox(tC0(iso_inverse(T))) * xpush(hdist0(T*C0) / 3);
   if(newanim) a.wherenow = Id, a.ltick = ticks, a.footphase = 0;
   }
 
@@ -605,6 +605,8 @@ EX void drawStats() {
     }
   string vers = VER;
   if(!nofps) vers += XLAT(" fps: ") + its(calcfps());
+  if(show_gmatrix_probes) vers += " gmatrix: " + its(last_gmatrix_found) + "/" + its(last_gmatrix_probes);
+  if(show_text_stats) vers += " texts: " + its(last_texts_merged) + "/" + its(last_text_batches) + " text cache: " + its(last_text_cache_hits) + "/" + its(last_text_cache_lookups);
   
   #if CAP_MEMORY_RESERVE
   if(reserve_limit && reserve_count < reserve_limit) {
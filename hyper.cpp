@@ -68,6 +68,7 @@
 #include "floorshapes.cpp"
 #include "usershapes.cpp"
 #include "drawing.cpp"
+#include "softraster.cpp"
 #include "mapeditor.cpp"
 #include "netgen.cpp"
 #include "nofont.cpp"
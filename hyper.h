@@ -737,6 +737,65 @@ template<class T> array<T, 4> make_array(T a, T b, T c, T d) { array<T,4> x; x[0
 template<class T> array<T, 3> make_array(T a, T b, T c) { array<T,3> x; x[0] = a; x[1] = b; x[2] = c; return x; }
 template<class T> array<T, 2> make_array(T a, T b) { array<T,2> x; x[0] = a; x[1] = b; return x; }
 
+/** hash functions used by hashtable */
+inline size_t hashtable_hash(unsigned long long x) { x ^= x >> 33; x *= 0xFF51AFD7ED558CCDull; x ^= x >> 33; return x; }
+template<class T> size_t hashtable_hash(T* p) { return hashtable_hash((unsigned long long) (size_t) p); }
+inline size_t hashtable_hash(const string& s) { return std::hash<string>()(s); }
+template<class T, class U> size_t hashtable_hash(const pair<T, U>& p) { return hashtable_hash(hashtable_hash(p.first) * 0x9E3779B97F4A7C15ull + hashtable_hash(p.second)); }
+template<class T, size_t N> size_t hashtable_hash(const array<T, N>& a) {
+  unsigned long long h = 0;
+  for(auto& x: a) h = h * 0x9E3779B97F4A7C15ull + (unsigned long long) x;
+  return hashtable_hash(h);
+  }
+
+/** An open addressing hash table, used for the coordinate maps of the masterless tilings, which are on the
+ *  hot path of map generation. It provides the part of the interface of map<K, V> that these use; entries
+ *  cannot be erased, and are kept in a deque in the order of insertion, so references to them stay valid.
+ */
+template<class K, class V> struct hashtable {
+  typedef pair<K, V> value_type;
+  typedef typename std::deque<value_type>::iterator iterator;
+  std::deque<value_type> entries;
+  /** indices to entries, or -1 if empty; the size is a power of two, at least twice the number of entries */
+  vector<int> index;
+
+  int find_entry(const K& k) const {
+    if(index.empty()) return -1;
+    size_t mask = index.size() - 1;
+    for(size_t i = hashtable_hash(k) & mask;; i = (i+1) & mask) {
+      int e = index[i];
+      if(e == -1 || entries[e].first == k) return e;
+      }
+    }
+
+  void place(int e) {
+    size_t mask = index.size() - 1;
+    size_t i = hashtable_hash(entries[e].first) & mask;
+    while(index[i] != -1) i = (i+1) & mask;
+    index[i] = e;
+    }
+
+  V& operator [] (const K& k) {
+    int e = find_entry(k);
+    if(e >= 0) return entries[e].second;
+    if(2 * (isize(entries) + 1) > isize(index)) {
+      index.assign(max(16, 2 * isize(index)), -1);
+      for(int i=0; i<isize(entries); i++) place(i);
+      }
+    entries.emplace_back(k, V());
+    place(isize(entries) - 1);
+    return entries.back().second;
+    }
+
+  iterator find(const K& k) { int e = find_entry(k); return e >= 0 ? entries.begin() + e : entries.end(); }
+  int count(const K& k) const { return find_entry(k) >= 0; }
+  int size() const { return isize(entries); }
+  bool empty() const { return entries.empty(); }
+  void clear() { entries.clear(); index.clear(); }
+  iterator begin() { return entries.begin(); }
+  iterator end() { return entries.end(); }
+  };
+
 namespace daily {
   extern bool on;
   extern int daily_id;
@@ -120,23 +120,35 @@ struct transmatrix {
   hyperpoint& operator [] (int i) { return (hyperpoint&)tab[i][0]; }
   const ld * operator [] (int i) const { return tab[i]; }
   
-  inline friend hyperpoint operator * (const transmatrix& T, const hyperpoint& H) {
+  /** T * H in dimension D; the compiler can unroll these loops completely */
+  template<int D> static hyperpoint apply(const transmatrix& T, const hyperpoint& H) {
     hyperpoint z;
-    for(int i=0; i<MDIM; i++) {
+    for(int i=0; i<D; i++) {
       z[i] = 0;
-      for(int j=0; j<MDIM; j++) z[i] += T[i][j] * H[j];
+      for(int j=0; j<D; j++) z[i] += T[i][j] * H[j];
       }
     return z;
     }
 
-  inline friend transmatrix operator * (const transmatrix& T, const transmatrix& U) {
+  /** T * U in dimension D */
+  template<int D> static transmatrix multiply(const transmatrix& T, const transmatrix& U) {
     transmatrix R;
-    for(int i=0; i<MDIM; i++) for(int j=0; j<MDIM; j++) {
+    for(int i=0; i<D; i++) for(int j=0; j<D; j++) {
       R[i][j] = 0;
-      for(int k=0; k<MDIM; k++)
+      for(int k=0; k<D; k++)
         R[i][j] += T[i][k] * U[k][j];
       }
     return R;
+    }
+
+  inline friend hyperpoint operator * (const transmatrix& T, const hyperpoint& H) {
+    if(MDIM == 3) return apply<3>(T, H);
+    return apply<MAXMDIM>(T, H);
+    }
+
+  inline friend transmatrix operator * (const transmatrix& T, const transmatrix& U) {
+    if(MDIM == 3) return multiply<3>(T, U);
+    return multiply<MAXMDIM>(T, U);
     }  
   };
 
@@ -835,6 +847,38 @@ EX transmatrix inverse(const transmatrix& T) {
     }
   }
 
+/** inverse of an orthogonal matrix, i.e., transpose */
+EX transmatrix ortho_inverse(transmatrix T) {
+  for(int i=1; i<MDIM; i++) for(int j=0; j<i; j++) swap(T[i][j], T[j][i]);
+  return T;
+  }
+
+/** inverse of a matrix preserving the Minkowski form */
+EX transmatrix pseudo_ortho_inverse(transmatrix T) {
+  T = ortho_inverse(T);
+  for(int i=0; i<LDIM; i++) T[i][LDIM] = -T[i][LDIM], T[LDIM][i] = -T[LDIM][i];
+  return T;
+  }
+
+/** \brief inverse of an isometry
+ *  Much faster than hr::inverse, but only correct if T is an isometry of the current geometry
+ *  (so for example not after mscale). Falls back to hr::inverse in geometries where there is no shortcut.
+ */
+EX transmatrix iso_inverse(const transmatrix& T) {
+  if(hyperbolic) return pseudo_ortho_inverse(T);
+  if(sphere) return ortho_inverse(T);
+  if(euclid) {
+    transmatrix U = Id;
+    for(int i=0; i<LDIM; i++) for(int j=0; j<LDIM; j++) U[i][j] = T[j][i];
+    for(int i=0; i<LDIM; i++) {
+      U[i][LDIM] = 0;
+      for(int j=0; j<LDIM; j++) U[i][LDIM] -= T[j][i] * T[j][LDIM];
+      }
+    return U;
+    }
+  return inverse(T);
+  }
+
 EX pair<ld, hyperpoint> product_decompose(hyperpoint h) {
   ld z = zlevel(h);
   return make_pair(z, mscale(h, -z));
@@ -792,16 +792,11 @@ EX void applymodel(hyperpoint H, hyperpoint& ret) {
     case mdFormula: {
       dynamicval<eModel> m(pmodel, models::basic_model);
       applymodel(H, ret);
-      exp_parser ep;
-      ep.extra_params["z"] = cld(ret[0], ret[1]);
-      ep.extra_params["cx"] = ret[0];
-      ep.extra_params["cy"] = ret[1];
-      ep.extra_params["cz"] = ret[2];
-      ep.extra_params["ux"] = H[0];
-      ep.extra_params["uy"] = H[1];
-      ep.extra_params["uz"] = H[2];
-      ep.s = models::formula;
-      cld res = ep.parse();
+      static const vector<string> names = {"z", "cx", "cy", "cz", "ux", "uy", "uz"};
+      static exp_program formula_program;
+      formula_program.compile_if_needed(models::formula, names);
+      cld values[7] = {cld(ret[0], ret[1]), ret[0], ret[1], ret[2], H[0], H[1], H[2]};
+      cld res = formula_program.evaluate(values);
       ret[0] = real(res);
       ret[1] = imag(res);
       ret[2] = 0;
@@ -841,6 +836,128 @@ EX void applymodel(hyperpoint H, hyperpoint& ret) {
   ghcheck(ret,H_orig);
   }
 
+/** can applymodel_batch use one of its dedicated kernels for the current model and geometry? */
+EX bool applymodel_batch_available() {
+  if(GDIM != 2 || nonisotropic || prod || spatial_graphics) return false;
+  switch(pmodel) {
+    case mdDisk:
+      return !vid.camera_angle;
+    case mdHalfplane: case mdHyperboloid: case mdHyperboloidFlat:
+    case mdEquidistant: case mdEquiarea:
+      return true;
+    case mdBand:
+      return models::model_transition == 1;
+    default:
+      return false;
+    }
+  }
+
+/** apply the current model to the n points in H, writing the results to ret; gives the same results as calling applymodel on each point, but the model is chosen and its parameters are computed once per batch, and the common models (Poincaré, Klein, half-plane, band, equidistant, hyperboloid) run as straight loops without per-point dispatch */
+EX void applymodel_batch(const hyperpoint *H, hyperpoint *ret, int n) {
+  if(!applymodel_batch_available()) {
+    for(int i=0; i<n; i++) applymodel(H[i], ret[i]);
+    return;
+    }
+  
+  switch(pmodel) {
+    case mdDisk: {
+      const ld alpha = vid.alpha;
+      const ld ztop = vid.xres * current_display->eyewidth() / 2 / current_display->radius;
+      const ld ipd = vid.ipd;
+      const bool eu = euclid;
+      for(int i=0; i<n; i++) {
+        ld tz = eu ? (1+alpha) : alpha+H[i][2];
+        if(tz < BEHIND_LIMIT && tz > -BEHIND_LIMIT) tz = BEHIND_LIMIT;
+        ret[i][0] = H[i][0] / tz;
+        ret[i][1] = H[i][1] / tz;
+        ret[i][2] = ztop - ipd / tz / 2;
+        if(MAXMDIM == 4) ret[i][3] = 1;
+        }
+      return;
+      }
+    
+    case mdHalfplane: {
+      const ld alpha = vid.alpha;
+      const ld scale = models::halfplane_scale;
+      const ld osin = models::osin, ocos = models::ocos;
+      for(int i=0; i<n; i++) {
+        ld s = 1 / (alpha + H[i][2]);
+        ld x = H[i][0] * s, y = H[i][1] * s;
+        models::apply_orientation(x, y);
+        y += 1;
+        double rad = 0;
+        rad += x*x; rad += y*y;
+        x /= -rad; y /= -rad;
+        y += .5;
+        models::apply_orientation(x, y);
+        x *= scale; y *= scale;
+        ret[i][0] = -osin - x;
+        ret[i][1] = ocos + y;
+        ret[i][2] = 0;
+        if(MAXMDIM == 4) ret[i][3] = 1;
+        ghcheck(ret[i], H[i]);
+        }
+      return;
+      }
+    
+    case mdHyperboloid: case mdHyperboloidFlat: {
+      const bool flat = pmodel == mdHyperboloidFlat;
+      const ld alpha = vid.alpha;
+      const ld topz = models::top_z;
+      for(int i=0; i<n; i++) {
+        hyperpoint h = H[i];
+        if(!flat) {
+          if(h[2] > topz) {
+            ld scale = sqrt(topz*topz-1) / hypot_d(2, h);
+            h *= scale;
+            h[2] = topz;
+            }
+          }
+        else {
+          h = space_to_perspective(h, alpha);
+          h[2] = 1 - alpha;
+          }
+        ret[i][0] = h[0] / 3;
+        ret[i][1] = (1 - h[2]) / 3;
+        ret[i][2] = h[1] / 3;
+        models::apply_ball(ret[i][2], ret[i][1]);
+        ghcheck(ret[i], H[i]);
+        }
+      return;
+      }
+    
+    case mdEquidistant: case mdEquiarea: {
+      const bool area = pmodel == mdEquiarea;
+      for(int i=0; i<n; i++) {
+        ld rad = hypot_d(2, H[i]);
+        if(rad == 0) rad = 1;
+        ld d = hdist0(H[i]);
+        if(area && sphere)
+          d = sqrt(2*(1 - cos(d))) * M_PI / 2;
+        else if(area && hyperbolic)
+          d = sqrt(2*(cosh(d) - 1)) / 1.5;
+        ret[i] = H[i] * (d / rad / M_PI);
+        ret[i][2] = 0;
+        if(MAXMDIM == 4) ret[i][3] = 1;
+        ghcheck(ret[i], H[i]);
+        }
+      return;
+      }
+    
+    case mdBand: {
+      for(int i=0; i<n; i++) {
+        makeband(H[i], ret[i], band_conformal);
+        ghcheck(ret[i], H[i]);
+        }
+      return;
+      }
+    
+    default:
+      for(int i=0; i<n; i++) applymodel(H[i], ret[i]);
+      return;
+    }
+  }
+
 // game-related graphics
 
 EX transmatrix sphereflip; // on the sphere, flip
@@ -1104,6 +1221,72 @@ void drawrec(cell *c, const transmatrix& V) {
 
 vector<tuple<heptspin, hstate, transmatrix, ld> > drawn_cells;
 
+/** number of threads used by hrmap_standard::draw to compute in_smart_range in advance */
+EX int draw_threads = 1;
+
+/** in_smart_range results for the entries of drawn_cells, computed in advance by the worker threads:
+ *  bit 0 is for the cell itself, bit 1+d for the BITRUNCATED cell in direction d
+ */
+vector<flagtype> drawn_smart;
+
+/** which bits of drawn_smart are known; a BITRUNCATED neighbor which did not exist yet is unknown,
+ *  since drawing the earlier cells may create it
+ */
+vector<flagtype> drawn_smart_known;
+
+/** can draw_smart_ranges run in threads? in_smart_range must not touch global state, which
+ *  (via applymodel) is guaranteed only for these models
+ */
+bool can_precompute_smart_range() {
+  #if CAP_THREAD
+  if(draw_threads <= 1) return false;
+  if(!(vid.use_smart_range || quotient || euwrap)) return false;
+  if(hybrid::pmap || WDIM == 3 || GOLDBERG || IRREGULAR || nonisotropic || prod) return false;
+  if(S7 >= 63) return false;
+  return pmodel == mdDisk || pmodel == mdPerspective;
+  #else
+  return false;
+  #endif
+  }
+
+/** compute drawn_smart for the entries from a to b of drawn_cells */
+void draw_smart_ranges(int a, int b) {
+  for(int i=a; i<b; i++) {
+    const auto& dc = drawn_cells[i];
+    auto& hs = get<0>(dc);
+    const transmatrix& V = get<2>(dc);
+    cell *c = hs.at->c7;
+    transmatrix V1 = hs.mirrored ? V * Mirror : V;
+    flagtype res = 0, known = 1;
+    if(in_smart_range(V1)) res |= 1;
+    if(BITRUNCATED) for(int d=0; d<S7; d++) {
+      int ds = hs.at->c.fix(hs.spin + d);
+      if(!c->move(ds)) continue;
+      known |= flagtype(2) << d;
+      if(c->c.spin(ds) == 0 && in_smart_range(V1 * cgi.hexmove[d]))
+        res |= flagtype(2) << d;
+      }
+    drawn_smart[i] = res;
+    drawn_smart_known[i] = known;
+    }
+  }
+
+/** the threaded phase of hrmap_standard::draw: compute drawn_smart for the entries from a to b;
+ *  the cells themselves are then drawn in the usual order, so the result does not depend on the threads
+ */
+void precompute_smart_ranges(int a, int b) {
+  drawn_smart.resize(b);
+  drawn_smart_known.resize(b);
+  #if CAP_THREAD
+  int qty = min(draw_threads, (b-a) / 64);
+  if(qty > 1) {
+    draw_pool.run(qty, [=] (int k) { draw_smart_ranges(a + (b-a)*k/qty, a + (b-a)*(k+1)/qty); });
+    return;
+    }
+  #endif
+  draw_smart_ranges(a, b);
+  }
+
 bool in_multi = false;
 
 void hrmap_standard::draw() {
@@ -1133,7 +1316,15 @@ void hrmap_standard::draw() {
     }
   drawn_cells.clear();
   drawn_cells.emplace_back(viewctr, hsOrigin, cview(), band_shift);
+  bool precompute = can_precompute_smart_range();
+  int precomputed = 0;
   for(int i=0; i<isize(drawn_cells); i++) {    
+    if(precompute && i == precomputed) {
+      precomputed = isize(drawn_cells);
+      precompute_smart_ranges(i, precomputed);
+      }
+    auto smart = [&] (int bit) { return precompute && ((drawn_smart_known[i] >> bit) & 1) ? int((drawn_smart[i] >> bit) & 1) : -1; };
+
     // prevent reallocation due to insertion
     if(drawn_cells.capacity() < drawn_cells.size() + 16)
       drawn_cells.reserve(max<size_t>(2 * drawn_cells.size(), 128));
@@ -1175,7 +1366,7 @@ void hrmap_standard::draw() {
     #endif
     
     else {
-      if(do_draw(c, V1)) {
+      if(do_draw(c, V1, smart(0))) {
         transmatrix V2 = actualV(hs, V1);
         drawcell(cellwalker(c, 0, hs.mirrored), V2);
         draw = true;
@@ -1186,7 +1377,7 @@ void hrmap_standard::draw() {
         // createMov(c, ds);
         if(c->move(ds) && c->c.spin(ds) == 0) {
           transmatrix V2 = V1 * cgi.hexmove[d];
-          if(do_draw(c->move(ds), V2))
+          if(do_draw(c->move(ds), V2, smart(1+d)))
             draw = true,
             drawcell(cellwalker(c->move(ds), 0, hs.mirrored ^ c->c.mirror(ds)), V2);
           }
@@ -2045,6 +2236,11 @@ bool limited_generation(cell *c) {
   }
 
 EX bool do_draw(cell *c, const transmatrix& T) {
+  return do_draw(c, T, -1);
+  }
+
+/** do_draw, where smart is the result of in_smart_range(T) if it is already known, or -1 */
+EX bool do_draw(cell *c, const transmatrix& T, int smart) {
 
   if(hybrid::pmap) return hybrid::do_draw(c, T);
   if(WDIM == 3) {
@@ -2103,7 +2299,7 @@ EX bool do_draw(cell *c, const transmatrix& T) {
     }
   if(cells_drawn > vid.cells_drawn_limit) return false;
   bool usr = vid.use_smart_range || quotient || euwrap;
-  if(usr && cells_drawn >= 50 && !in_smart_range(T) && !(WDIM == 2 && GDIM == 3 && hdist0(tC0(T)) < 2.5)) return false;
+  if(usr && cells_drawn >= 50 && !(smart == -1 ? in_smart_range(T) : smart) && !(WDIM == 2 && GDIM == 3 && hdist0(tC0(T)) < 2.5)) return false;
   if(vid.use_smart_range == 2 && !limited_generation(c)) return false;
   return true; 
   }
@@ -27,6 +27,7 @@ EX bool chaosUnlocked = false;
 EX bool chaosAchieved = false;
 
 EX void doOvergenerate() {
+  if(memory_budget_exceeded) return;
   for(int i=0; i<numplayers(); i++)
     setdist(playerpos(i), 7 - getDistLimit() - genrange_bonus, NULL);
   }
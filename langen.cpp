@@ -8,6 +8,7 @@
 #include <vector>
 #include <cstdlib>
 #include <set>
+#include <algorithm>
 
 #define GEN_M 0
 #define GEN_F 1
@@ -113,6 +114,53 @@ std::map<hashcode, std::string> buildHashTable(std::set<std::string>& s) {
   return res;
   }
 
+/** the mixing function of the perfect hashes; language.cpp uses the same one */
+hashcode perfect_mix(hashcode h, hashcode d) {
+  h ^= d * 0x9E3779B1u;
+  h ^= h >> 16;
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  return h;
+  }
+
+/** print a perfect hash of the given hash codes, as the arrays name_displace and name_slots;
+ *  the code h is found at name_slots[perfect_mix(h, name_displace[perfect_mix(h, 0) & (buckets-1)]) & (slots-1)]
+ */
+void printPerfectHash(const char *name, const std::vector<hashcode>& codes) {
+  int buckets = 1, slots = 1;
+  while(buckets * 4 < isize(codes)) buckets *= 2;
+  while(slots * 4 < isize(codes) * 5) slots *= 2;
+  std::vector<std::vector<int>> in_bucket(buckets);
+  for(int i=0; i<isize(codes); i++) in_bucket[perfect_mix(codes[i], 0) & (buckets-1)].push_back(i);
+
+  // place the largest buckets first, each with the first displacement which moves all its codes into free slots
+  std::vector<int> order;
+  for(int b=0; b<buckets; b++) order.push_back(b);
+  std::stable_sort(order.begin(), order.end(), [&] (int a, int b) { return in_bucket[a].size() > in_bucket[b].size(); });
+  std::vector<int> displace(buckets, 0), slot(slots, -1);
+  for(int b: order) if(!in_bucket[b].empty()) {
+    for(int d=1;; d++) {
+      std::vector<int> used;
+      for(int i: in_bucket[b]) {
+        int s = perfect_mix(codes[i], d) & (slots-1);
+        if(slot[s] != -1 || std::find(used.begin(), used.end(), s) != used.end()) break;
+        used.push_back(s);
+        }
+      if(isize(used) < isize(in_bucket[b])) continue;
+      displace[b] = d;
+      for(int k=0; k<isize(used); k++) slot[used[k]] = in_bucket[b][k];
+      break;
+      }
+    }
+
+  printf("const int %s_displace[%d] = {", name, buckets);
+  for(int b=0; b<buckets; b++) printf("%s%d,", b % 16 ? " " : "\n  ", displace[b]);
+  printf("\n  };\n\n");
+  printf("const int %s_slots[%d] = {", name, slots);
+  for(int s=0; s<slots; s++) printf("%s%d,", s % 16 ? " " : "\n  ", slot[s]);
+  printf("\n  };\n\n");
+  }
+
 const char *escape(std::string s, const std::string& dft) {
   if(s == "") {
     printf("/*MISSING*/ ");
@@ -385,10 +433,15 @@ int main() {
   
   printf("hashcode hashval = 0x%x;\n\n", hashval);
   
+  // the repeated entries go last, so that the indices in the perfect hashes do not depend on REPEATED
+  std::vector<hashcode> hs, hn;
+  
   printf("sentence all_sentences[] = {\n");
   
-  for(auto&& elt : ms) {
+  for(bool repeated: {false, true}) for(auto&& elt : ms) {
     const std::string& s = elt.second;
+    if(isrepeat(s) != repeated) continue;
+    if(!repeated) hs.push_back(elt.first);
     if(isrepeat(s)) printf("#if REPEATED\n");    
     printf("  {0x%x, { // %s\n", elt.first, escape(s, s));
     for(int i=1; i<NUMLAN; i++) printf("   %s,\n", escape(d[i][s], s));
@@ -399,8 +452,10 @@ int main() {
 
   printf("fullnoun all_nouns[] = {\n");
   
-  for(auto&& elt : mn) {
+  for(bool repeated: {false, true}) for(auto&& elt : mn) {
     const std::string& s = elt.second;
+    if(isrepeat(s) != repeated) continue;
+    if(!repeated) hn.push_back(elt.first);
     if(isrepeat(s)) printf("#if REPEATED\n");
     printf("  {0x%x, %d, { // \"%s\"\n", elt.first,
       (nothe.count(s) ? 1:0) + (plural.count(s) ? 2:0),
@@ -418,6 +473,8 @@ int main() {
     if(isrepeat(s)) printf("#endif\n");
     }
 
-  printf("  };\n");
+  printf("  };\n\n");
 
+  printPerfectHash("all_sentences", hs);
+  printPerfectHash("all_nouns", hn);
   }
@@ -75,21 +75,25 @@ hashcode langhash(const string& s) {
   return r;
   }
 
-template<class T> const T* findInHashTableS(string s, const T *table, int size) {
-  int b = 0, e = size;
+/** the mixing function of the perfect hashes generated by langen */
+hashcode perfect_mix(hashcode h, hashcode d) {
+  h ^= d * 0x9E3779B1u;
+  h ^= h >> 16;
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  return h;
+  }
+
+/** find s in the table, using the perfect hash (displace, slots) generated for it by langen */
+template<class T, size_t B, size_t S> const T* findInPerfectHash(const string& s, const T *table, const int (&displace)[B], const int (&slots)[S]) {
   hashcode h = langhash(s);
-  while(b!=e) {
-    int m = (b+e)>>1;
-    // printf("b=%d e=%d m=%d h=%x s=%x\n", b, e, m, table[m].langhash, h);
-    if(table[m].langhash >= h) e = m;
-    else b = m+1;
-    }
-  if(e != size && table[e].langhash == h)
-    return &table[e];
+  int i = slots[perfect_mix(h, displace[perfect_mix(h, 0) & (B-1)]) & (S-1)];
+  if(i >= 0 && table[i].langhash == h)
+    return &table[i];
   return NULL;
   }
 
-#define findInHashTable(s,t) findInHashTableS(s, t, sizeof(t) / sizeof(t[0]))
+#define findInHashTable(s,t) findInPerfectHash(s, t, t##_displace, t##_slots)
 #endif
 
 string choose3(int g, string a, string b, string c) {
@@ -315,51 +319,53 @@ void parrep(string& x, string w, stringpar p) {
 void postrep(string& s) {
   }
 
+/** results of XLAT, keyed by the language, the genders, the template and the parameters;
+ *  translating a sentence needs many find-and-replace passes, and the same ones are requested every frame
+ */
+hashtable<string, string> xlat_cache;
+
+/** xlat_cache is cleared when it reaches this size */
+EX int xlat_cache_limit = 4096;
+
+EX int xlat_cache_lookups, xlat_cache_hits;
+
+string XLAT_cached(const string& x, std::initializer_list<const stringpar*> pars) {
+  string key;
+  key += char('0' + lang());
+  key += char('0' + playergender());
+  key += char('0' + princessgender());
+  key += x;
+  for(auto p: pars) { key += '\0'; key += p->v; }
+  xlat_cache_lookups++;
+  auto it = xlat_cache.find(key);
+  if(it != xlat_cache.end()) { xlat_cache_hits++; return it->second; }
+  string res = x;
+  basicrep(res);
+  int id = 0;
+  for(auto p: pars) parrep(res, its(++id), p->v);
+  postrep(res);
+  if(xlat_cache.size() >= xlat_cache_limit) xlat_cache.clear();
+  return xlat_cache[key] = res;
+  }
+
 /** translate the string @x */
 EX string XLAT(string x) { 
-  basicrep(x);
-  postrep(x);
-  return x;
+  return XLAT_cached(x, {});
   }
 EX string XLAT(string x, stringpar p1) { 
-  basicrep(x);
-  parrep(x,"1",p1.v);
-  postrep(x);
-  return x;
+  return XLAT_cached(x, {&p1});
   }
 EX string XLAT(string x, stringpar p1, stringpar p2) { 
-  basicrep(x);
-  parrep(x,"1",p1.v);
-  parrep(x,"2",p2.v);
-  postrep(x);
-  return x;
+  return XLAT_cached(x, {&p1, &p2});
   }
 EX string XLAT(string x, stringpar p1, stringpar p2, stringpar p3) { 
-  basicrep(x);
-  parrep(x,"1",p1.v);
-  parrep(x,"2",p2.v);
-  parrep(x,"3",p3.v);
-  postrep(x);
-  return x;
+  return XLAT_cached(x, {&p1, &p2, &p3});
   }
 EX string XLAT(string x, stringpar p1, stringpar p2, stringpar p3, stringpar p4) { 
-  basicrep(x);
-  parrep(x,"1",p1.v);
-  parrep(x,"2",p2.v);
-  parrep(x,"3",p3.v);
-  parrep(x,"4",p4.v);
-  postrep(x);
-  return x;
+  return XLAT_cached(x, {&p1, &p2, &p3, &p4});
   }
 EX string XLAT(string x, stringpar p1, stringpar p2, stringpar p3, stringpar p4, stringpar p5) { 
-  basicrep(x);
-  parrep(x,"1",p1.v);
-  parrep(x,"2",p2.v);
-  parrep(x,"3",p3.v);
-  parrep(x,"4",p4.v);
-  parrep(x,"5",p5.v);
-  postrep(x);
-  return x;
+  return XLAT_cached(x, {&p1, &p2, &p3, &p4, &p5});
   }
 
 
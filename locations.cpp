@@ -17,6 +17,7 @@ namespace hr {
 #if HDR
 
 extern int cellcount, heptacount;
+extern long long cellbytes, heptabytes, databytes, arenabytes;
 
 #define NODIR 126
 #define NOBARRIERS 127
@@ -168,6 +169,146 @@ template<class T> struct connection_table {
     }
   };
 
+struct cell;
+struct heptagon;
+
+/** size of arena slabs; slabs are also aligned to this, so that the slab of an object can be found from its address */
+static const int ARENA_SLAB = 1 << 16;
+/** object sizes are rounded up to a multiple of this */
+static const int ARENA_GRAIN = 8;
+/** the number of size classes */
+static const int ARENA_CLASSES = 64;
+
+/** A slab arena for cells, heptagons and their cdata.
+ *
+ *  Every map created by initcells() owns an arena (hrmap::arena), and everything
+ *  generated for that map (including its alternate and underlying maps) is allocated
+ *  there by tailored_alloc. Each slab serves a single size class, so objects with
+ *  variable-length connection tables are packed tightly.
+ *
+ *  Objects can still be freed one by one with tailored_delete (they go to the free
+ *  list of their size class in the arena which owns them), but destroying the arena 
+ *  releases all the slabs at once, without walking the graph.
+ */
+
+struct tailored_arena {
+
+  struct slab {
+    tailored_arena *owner;
+    slab *next;
+    int size_class;
+    };
+
+  /** objects start at this offset in each slab */
+  static const int header = (sizeof(slab) + 15) & ~15;
+
+  slab *slabs;
+  void *free_list[ARENA_CLASSES];
+  char *bump[ARENA_CLASSES], *bump_end[ARENA_CLASSES];
+
+  /** live objects in this arena, so that cellcount and heptacount stay correct after a bulk release */
+  int cells, heptagons;
+  /** bytes in live objects, and in all the slabs */
+  size_t bytes_used, bytes_reserved;
+  /** bytes in live cells, heptagons, and other objects (cdata) */
+  long long cell_bytes, heptagon_bytes, data_bytes;
+  /** the number of cell::mapid values handed out */
+  int cell_ids;
+
+  tailored_arena() {
+    slabs = NULL;
+    for(int i=0; i<ARENA_CLASSES; i++) free_list[i] = bump[i] = bump_end[i] = NULL;
+    cells = heptagons = 0;
+    bytes_used = bytes_reserved = 0;
+    cell_bytes = heptagon_bytes = data_bytes = 0;
+    cell_ids = 0;
+    }
+
+  static void *aligned_slab() {
+    while(true) {
+      void *p = NULL;
+      #if ISWINDOWS
+      p = _aligned_malloc(ARENA_SLAB, ARENA_SLAB);
+      #else
+      if(posix_memalign(&p, ARENA_SLAB, ARENA_SLAB)) p = NULL;
+      #endif
+      if(p) return p;
+      // behave like operator new, so that the memory reserve in savemem.cpp still works
+      auto handler = std::get_new_handler();
+      if(!handler) throw std::bad_alloc();
+      handler();
+      }
+    }
+
+  static void free_slab(slab *s) {
+    #if ISWINDOWS
+    _aligned_free(s);
+    #else
+    free(s);
+    #endif
+    }
+
+  void *allocate(int bytes) {
+    int id = (bytes + ARENA_GRAIN - 1) / ARENA_GRAIN;
+    if(id >= ARENA_CLASSES) {
+      printf("tailored_arena: object of %d bytes is too large\n", bytes);
+      exit(1);
+      }
+    int size = id * ARENA_GRAIN;
+    bytes_used += size;
+    if(free_list[id]) {
+      void *p = free_list[id];
+      free_list[id] = *((void**) p);
+      return p;
+      }
+    if(bump[id] + size > bump_end[id]) {
+      slab *s = (slab*) aligned_slab();
+      s->owner = this;
+      s->next = slabs;
+      s->size_class = id;
+      slabs = s;
+      bytes_reserved += ARENA_SLAB;
+      arenabytes += ARENA_SLAB;
+      bump[id] = (char*) s + header;
+      bump_end[id] = (char*) s + ARENA_SLAB;
+      }
+    void *p = bump[id];
+    bump[id] += size;
+    return p;
+    }
+
+  /** the slab containing p */
+  static slab *slab_of(void *p) {
+    return (slab*) (((uintptr_t) p) & ~(uintptr_t) (ARENA_SLAB - 1));
+    }
+
+  /** return p to the arena which owns it */
+  static void release(void *p) {
+    slab *s = slab_of(p);
+    tailored_arena *a = s->owner;
+    a->bytes_used -= s->size_class * ARENA_GRAIN;
+    *((void**) p) = a->free_list[s->size_class];
+    a->free_list[s->size_class] = p;
+    }
+
+  /** the size of the slot allocated for p */
+  static int object_size(void *p) { return slab_of(p)->size_class * ARENA_GRAIN; }
+
+  void count(cell* c, int d) { cells += d; cell_bytes += d * object_size(c); cellbytes += d * object_size(c); }
+  void count(heptagon* h, int d) { heptagons += d; heptagon_bytes += d * object_size(h); heptabytes += d * object_size(h); }
+  void count(void* p, int d) { data_bytes += d * object_size(p); databytes += d * object_size(p); }
+
+  ~tailored_arena();
+
+  tailored_arena(const tailored_arena&) = delete;
+  tailored_arena& operator=(const tailored_arena&) = delete;
+  };
+
+/** the arena where tailored_alloc currently allocates; maps switch it when they are created or restored */
+extern tailored_arena *current_arena;
+/** returns current_arena, or a global arena if there is no current map */
+tailored_arena *alloc_arena();
+
 /** Allocate a class T with a connection_table, but 
  *  with only `degree` connections. Also set yet
  *  unknown connections to NULL.
@@ -181,7 +322,9 @@ template<class T> T* tailored_alloc(int degree) {
   T* result;
 #ifndef NO_TAILORED_ALLOC
   int b = (char*)&sample->c.move_table[degree] + degree - (char*) sample;
-  result = (T*) new char[b];
+  tailored_arena *a = alloc_arena();
+  result = (T*) a->allocate(b);
+  a->count(result, 1);
   new (result) T();
 #else
   result = new T;
@@ -191,10 +334,27 @@ template<class T> T* tailored_alloc(int degree) {
   return result;
   }
 
-/** Counterpart to tailored_alloc(). */
+/** Allocate a fixed-size object (such as cdata) in the current arena. Free with tailored_delete. */
+template<class T, class... U> T* arena_new(U&&... u) {
+#ifndef NO_TAILORED_ALLOC
+  tailored_arena *a = alloc_arena();
+  T* result = new (a->allocate(sizeof(T))) T(std::forward<U>(u)...);
+  a->count(result, 1);
+  return result;
+#else
+  return new T(std::forward<U>(u)...);
+#endif
+  }
+
+/** Counterpart to tailored_alloc() and arena_new(). */
 template<class T> void tailored_delete(T* x) {
+#ifndef NO_TAILORED_ALLOC
+  tailored_arena::slab_of(x)->owner->count(x, -1);
   x->~T();  
-  delete[] ((char*) (x));
+  tailored_arena::release(x);
+#else
+  delete x;
+#endif
   }
 
 static const struct wstep_t { wstep_t() {} } wstep;
@@ -345,6 +505,7 @@ struct cell : gcell {
   int degree() { return type; }
 
   int listindex;    ///< used by celllister  
+  int mapid;        ///< stable id of this cell within its map, for indexing flat per-map tables
   heptagon *master; ///< heptagon who owns us; for 'masterless' tilings it contains coordinates instead
 
   connection_table<cell> c;
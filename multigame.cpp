@@ -45,6 +45,7 @@ void gamedata_all(gamedata& gd) {
   gd.store(currentmap);
   gd.store(cwt);
   gd.store(allmaps);
+  gd.store(current_arena);
   gd.store(shmup::on);
   gd.store(chaosmode);
   gd.store(*current_display);
@@ -315,7 +315,7 @@ EX namespace solnihv {
     ~hrmap_solnih() {
       delete binary_map;
       if(ternary_map) delete ternary_map;
-      for(auto& p: at) clear_heptagon(p.second);
+      if(!bulk_release()) for(auto& p: at) clear_heptagon(p.second);
       }
 
     transmatrix adjmatrix(int i, int j) {
@@ -781,13 +781,13 @@ EX namespace nilv {
   EX array<int,3> nilperiod, nilperiod_edit;
   
   struct hrmap_nil : hrmap {
-    unordered_map<mvec, heptagon*> at;
-    unordered_map<heptagon*, mvec> coords;
+    hashtable<mvec, heptagon*> at;
+    hashtable<heptagon*, mvec> coords;
     
     heptagon *getOrigin() override { return get_at(mvec_zero); }
     
     ~hrmap_nil() {
-      for(auto& p: at) clear_heptagon(p.second);
+      if(!bulk_release()) for(auto& p: at) clear_heptagon(p.second);
       }
 
     heptagon *get_at(mvec c) {
@@ -984,8 +984,8 @@ EX namespace hybrid {
     
     hrmap *underlying_map;
     
-    map<pair<cell*, int>, cell*> at;
-    map<cell*, pair<cell*, int>> where;
+    hashtable<pair<cell*, int>, cell*> at;
+    hashtable<cell*, pair<cell*, int>> where;
     
     heptagon *getOrigin() override { return underlying_map->getOrigin(); }
     
@@ -1015,7 +1015,7 @@ EX namespace hybrid {
     
     ~hrmap_hybrid() {
       in_underlying([] { delete currentmap; });
-      for(auto& p: at) tailored_delete(p.second);
+      if(!bulk_release()) for(auto& p: at) tailored_delete(p.second);
       }
   
     };
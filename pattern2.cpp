@@ -1500,36 +1500,46 @@ EX namespace patterns {
 
   EX string color_formula = "to01(rgb(x,y,z))";
   
-  cld compute_map_function(cell *c, int p, const string& formula) {
-    exp_parser ep;
-    ep.extra_params["p"] = p;
+  /** compiled color_formula */
+  exp_program color_program;
+
+  /** compute the values of the variables which the map function uses at c, and return their names; p (the color channel) is the first one, and it is left for the caller to set */
+  const vector<string>& map_function_variables(cell *c, vector<cld>& values) {
     switch(geometry) {
       #if CAP_CRYSTAL
       case gCrystal: {
+        static vector<string> names;
+        if(names.empty()) {
+          names.push_back("p");
+          for(int i=0; i<crystal::MAXDIM; i++) names.push_back("x"+its(i));
+          }
         crystal::ldcoord co = crystal::get_ldcoord(c);
+        values.resize(1+crystal::MAXDIM);
         for(int i=0; i<crystal::MAXDIM; i++)
-          ep.extra_params["x"+its(i)] = co[i];
-        break;
+          values[1+i] = co[i];
+        return names;
         }
       #endif
     
       default: {
+        static const vector<string> names = {"p", "x", "y", "z"};
+        static const vector<string> names_euclid = {"p", "x", "y", "z", "ex", "ey", "ez"};
         hyperpoint h = calc_relative_matrix(c, currentmap->gamestart(), C0) * C0;
-        ep.extra_params["x"] = h[0];
-        ep.extra_params["y"] = h[1];
-        ep.extra_params["z"] = h[2];
+        values.resize(euclid ? 7 : 4);
+        values[1] = h[0];
+        values[2] = h[1];
+        values[3] = h[2];
         if(euclid) {
           int x, y;
           tie(x,y) = cell_to_pair(c);
-          ep.extra_params["ex"] = x;
-          ep.extra_params["ey"] = y;
-          ep.extra_params["ez"] = -x-y;
+          values[4] = x;
+          values[5] = y;
+          values[6] = -x-y;
+          return names_euclid;
           }
-        break;
+        return names;
         }
       }
-    ep.s = formula;
-    return ep.parse();
     }
   
   EX hookset<int(cell*)> *hooks_generate_canvas;
@@ -1652,8 +1662,11 @@ EX namespace patterns {
         }
       case 'f': {
         color_t res;
+        static vector<cld> values;
+        color_program.compile_if_needed(color_formula, map_function_variables(c, values));
         for(int i=0; i<3; i++) {
-          ld v = real(compute_map_function(c, 1+i, color_formula));
+          values[0] = 1+i;
+          ld v = real(color_program.evaluate(&values[0]));
           if(v < 0) part(res, i) = 0;
           else if(v > 1) part(res, i) = 255;
           else part(res, i) = int(v * 255 + .5);
@@ -2596,7 +2609,7 @@ EX namespace linepatterns {
   
     vid.linewidth *= width;
 
-    if(any()) for(map<cell*, transmatrix>::iterator it = gmatrix.begin(); it != gmatrix.end(); it++) {
+    if(any()) for(auto it = gmatrix.begin(); it != gmatrix.end(); it++) {
       cell *c = it->first;
       transmatrix& V = it->second;
       
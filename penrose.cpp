@@ -369,7 +369,7 @@ struct hrmap_kite : hrmap {
     }
   
   ~hrmap_kite() {
-    clearfrom(origin);
+    if(!bulk_release()) clearfrom(origin);
     }
 
   };
@@ -386,7 +386,7 @@ struct hrmap_quotient : hrmap_standard {
   heptagon *getOrigin() { return allh[0]; }
 
   ~hrmap_quotient() {
-    for(int i=0; i<isize(allh); i++) {
+    if(!bulk_release()) for(int i=0; i<isize(allh); i++) {
       clearHexes(allh[i]);
       tailored_delete(allh[i]);
       }
@@ -70,12 +70,8 @@ void celldrawer::drawcell_in_radar() {
   cell *c = cw.at;
   #if CAP_SHMUP
   if(shmup::on) {
-    pair<shmup::mit, shmup::mit> p = 
-      shmup::monstersAt.equal_range(c);
-    for(shmup::mit it = p.first; it != p.second; it++) {
-      shmup::monster* m = it->second;
+    for(shmup::monster *m = shmup::monstersAt.at(c); m; m = m->next_stored)
       addradar(V*m->at, minf[m->type].glyph, minf[m->type].color, 0xFF0000FF);
-      }
     }
   #endif
   if(c->monst) 
@@ -598,7 +598,8 @@ EX namespace reg3 {
     hrmap_quotient3 *quotient_map;
     
     unordered_map<heptagon*, pair<heptagon*, transmatrix>> reg_gmatrix;
-    unordered_map<heptagon*, vector<pair<heptagon*, transmatrix> > > altmap;
+    /** heptagons by their alt, and then by bucketer() of their position relative to the alt */
+    unordered_map<heptagon*, unordered_map<int, vector<pair<heptagon*, transmatrix> > > > altmap;
 
     vector<cell*> spherecells;  
 
@@ -655,7 +656,7 @@ EX namespace reg3 {
         }
       
       reg_gmatrix[origin] = make_pair(alt, T);
-      altmap[alt].emplace_back(origin, T);
+      add_to_altmap(alt, origin, T);
       
       celllister cl(origin->c7, 4, 100000, NULL);
       for(cell *c: cl.lst) {
@@ -710,6 +711,27 @@ EX namespace reg3 {
       return quotient_map->allh[h->fieldval];
       }
 
+    void add_to_altmap(heptagon *alt, heptagon *h, const transmatrix& T) {
+      altmap[alt][bucketer(tC0(T))].emplace_back(h, T);
+      }
+
+    /** find the heptagon in altmap[alt] centered at hT, if any; the neighboring buckets are checked too, since hT may be rounded to the other side */
+    pair<heptagon*, transmatrix> *find_in_altmap(heptagon *alt, const hyperpoint& hT, ld& err) {
+      auto& buckets = altmap[alt];
+      for(int s: {1, -1}) {
+        if(s == -1 && !elliptic) break;
+        int b = bucketer(hT * s);
+        for(int dx=-1; dx<=1; dx++)
+        for(int dy=-1; dy<=1; dy++)
+        for(int dz=-1; dz<=1; dz++) {
+          auto it = buckets.find(b + dx + 1000 * dy + 1000000 * dz);
+          if(it == buckets.end()) continue;
+          for(auto& p2: it->second) if((err = intval(tC0(p2.second), hT)) < 1e-3) return &p2;
+          }
+        }
+      return nullptr;
+      }
+
     heptagon *create_step(heptagon *parent, int d) override {
       auto& p1 = reg_gmatrix[parent];
       if(DEB) println(hlog, "creating step ", parent, ":", d, ", at ", p1.first, tC0(p1.second));
@@ -731,11 +753,12 @@ EX namespace reg3 {
       
       if(DEB) println(hlog, "searching at ", alt, ":", hT);
 
-      if(DEB) for(auto& p2: altmap[alt]) println(hlog, "for ", tC0(p2.second), " intval is ", intval(tC0(p2.second), hT));
+      if(DEB) for(auto& b: altmap[alt]) for(auto& p2: b.second) println(hlog, "for ", tC0(p2.second), " intval is ", intval(tC0(p2.second), hT));
       
       ld err;
       
-      for(auto& p2: altmap[alt]) if((err = intval(tC0(p2.second), hT)) < 1e-3) {
+      if(auto found = find_in_altmap(alt, hT, err)) {
+        auto& p2 = *found;
         if(err > worst_error1) println(hlog, format("worst_error1 = %lg", double(worst_error1 = err)));
         // println(hlog, "YES found in ", isize(altmap[alt]));
         if(DEB) println(hlog, "-> found ", p2.first);
@@ -795,7 +818,7 @@ EX namespace reg3 {
       created->distance = parent->distance + 1;
       fixmatrix(T);
       reg_gmatrix[created] = make_pair(alt, T);
-      altmap[alt].emplace_back(created, T);
+      add_to_altmap(alt, created, T);
       created->c.connect(d2, parent, d, false);
       return created;
       }
@@ -806,7 +829,7 @@ EX namespace reg3 {
         delete binary_map;
         }
       if(quotient_map) delete quotient_map;
-      clearfrom(origin);
+      if(!bulk_release()) clearfrom(origin);
       }
     
     map<heptagon*, int> reducers;
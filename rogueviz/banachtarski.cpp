@@ -302,7 +302,7 @@ void bantar_frame() {
 
   calcparam();
   
-  vector<unique_ptr<drawqueueitem>> subscr[4];
+  vector<drawqueue_ptr> subscr[4];
   
   compute_graphical_distance();
 
@@ -393,7 +393,7 @@ void bantar_frame() {
     subscr[i] = move(ptds);
     }
   
-  map<int, map<int, vector<unique_ptr<drawqueueitem>>>> xptds;
+  map<int, map<int, vector<drawqueue_ptr>>> xptds;
   for(int i=0; i<4; i++) for(auto& p: subscr[i])
     xptds[int(p->prio)][i].push_back(move(p));
   
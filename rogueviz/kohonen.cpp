@@ -122,14 +122,88 @@ int qpct = 100;
 int t, lpct, cells;
 double maxdist;
 
+int som_threads = 1;
+
+/** find the best matching neuron among n0..n1-1 for the sample values x, i.e., the first one with vnorm smaller
+ *  than bdiff; bdiff and bid are updated if it is found. Eight neurons are compared at once; each of them
+ *  still sums the columns in the same order as vnorm, so the results are identical to the simple loop
+ */
+void best_matching(const double *x, int n0, int n1, double& bdiff, int& bid) {
+  const int B = 8;
+  const double *w = &weights[0];
+  int n = n0;
+  for(; n + B <= n1; n += B) {
+    const double *row[B];
+    double acc[B];
+    for(int j=0; j<B; j++) row[j] = &net[n+j].net[0], acc[j] = 0;
+    for(int k=0; k<columns; k++) {
+      double xk = x[k], wk = w[k];
+      for(int j=0; j<B; j++) acc[j] += sqr((row[j][k] - xk) * wk);
+      }
+    for(int j=0; j<B; j++) if(acc[j] < bdiff) bdiff = acc[j], bid = n+j;
+    }
+  for(; n < n1; n++) {
+    const double *row = &net[n].net[0];
+    double diff = 0;
+    for(int k=0; k<columns; k++) diff += sqr((row[k] - x[k]) * w[k]);
+    if(diff < bdiff) bdiff = diff, bid = n;
+    }
+  }
+
+/** like best_matching, but for the neurons n0..n0+q-1 given as a transposed tile: the column k of the neuron n0+j is
+ *  T[k*q+j]. Neighboring neurons are then adjacent in memory, so the loop over them can be vectorized
+ */
+void best_matching_tile(const double *x, const double *T, int n0, int q, double& bdiff, int& bid) {
+  const int B = 8;
+  const double *w = &weights[0];
+  int j0 = 0;
+  for(; j0 + B <= q; j0 += B) {
+    double acc[B];
+    for(int j=0; j<B; j++) acc[j] = 0;
+    for(int k=0; k<columns; k++) {
+      double xk = x[k], wk = w[k];
+      const double *t = T + k*q + j0;
+      for(int j=0; j<B; j++) acc[j] += sqr((t[j] - xk) * wk);
+      }
+    for(int j=0; j<B; j++) if(acc[j] < bdiff) bdiff = acc[j], bid = n0+j0+j;
+    }
+  for(; j0 < q; j0++) {
+    double diff = 0;
+    for(int k=0; k<columns; k++) diff += sqr((T[k*q+j0] - x[k]) * w[k]);
+    if(diff < bdiff) bdiff = diff, bid = n0+j0;
+    }
+  }
+
+/** run f(k, a, b) for the parts [a, b) of [0, N), in som_threads threads if N is at least min_per_thread per thread */
+template<class T> void som_parallel(int N, int min_per_thread, const T& f) {
+  int qty = 1;
+  #if CAP_THREAD
+  qty = max(1, min(som_threads, N / max(min_per_thread, 1)));
+  if(qty > 1) {
+    vector<std::thread> v;
+    for(int k=1; k<qty; k++)
+      v.emplace_back([&f, N, qty, k] { f(k, (long long) N*k/qty, (long long) N*(k+1)/qty); });
+    f(0, 0, N/qty);
+    for(auto& t: v) t.join();
+    return;
+    }
+  #endif
+  f(0, 0, N);
+  }
+
 neuron& winner(int id) {
   double bdiff = HUGE_VAL;
-  neuron *bcell = NULL;
-  for(neuron& n: net) {
-    double diff = vnorm(n.net, data[id].val);
-    if(diff < bdiff) bdiff = diff, bcell = &n;
-    }
-  return *bcell;
+  int bid = -1;
+  const double *x = &data[id].val[0];
+  int N = isize(net);
+  if(som_threads > 1 && (long long) N * columns >= (1<<20)) {
+    // split the neurons; the parts are combined in order, so ties are broken as in the serial version
+    vector<pair<double, int>> res(som_threads, make_pair(HUGE_VAL, -1));
+    som_parallel(N, 1024, [&] (int k, int a, int b) { best_matching(x, a, b, res[k].first, res[k].second); });
+    for(auto& r: res) if(r.second != -1 && r.first < bdiff) bdiff = r.first, bid = r.second;
+    }
+  else best_matching(x, 0, N, bdiff, bid);
+  return net[bid];
   }
 
 void setindex(bool b) {
@@ -501,16 +575,16 @@ int krad;
 
 double ttpower = 1;
 
-void step() {
+/** the number of samples trained on at once; 0 or 1 for the classic online training, one sample per step */
+int batch_size = 0;
 
-  if(t == 0) return;
-  sominit(2);
-  
+/** compute the neighborhood parameters for the current t, and report the progress */
+void schedule(double& sigma, int& dispid) {
   double tt = (t-1.) / tmax;
   tt = pow(tt, ttpower);
 
-  double sigma = maxdist * tt;
-  int dispid = int(dispersion_count * tt);
+  sigma = maxdist * tt;
+  dispid = int(dispersion_count * tt);
 
   if(qpct) {
     int pct = (int) ((qpct * (t+.0)) / tmax);
@@ -525,22 +599,10 @@ void step() {
         printf("t = %6d/%6d %3d%% dispid=%5d maxudist=%10.7lf\n", t, tmax, pct, dispid, maxudist);
       }
     }
-  int id = hrand(samples);
-  neuron& n = winner(id);
-  whowon.resize(samples);
-  whowon[id] = &n;
-    
-  /* 
-  for(neuron& n2: net) {
-    int d = celldistance(n.where, n2.where);
-    double nu = learning_factor; 
-//  nu *= exp(-t*(double)maxdist/perdist);
-//  nu *= exp(-t/t2);
-    nu *= exp(-sqr(d/sigma));
-    for(int k=0; k<columns; k++)
-      n2.net[k] += nu * (irisdata[id][k] - n2.net[k]);
-    } */
-    
+  }
+
+/** call f(n2, nu) for the neurons n2 in the neighborhood of n, where nu is the learning factor for n2 */
+template<class T> void for_neighborhood(neuron& n, double sigma, int dispid, const T& f) {
   auto cid = get_cellcrawler_id(n.where);
   cellcrawler& s = scc[cid.first];
   s.sprawl(cellwalker(n.where, cid.second));
@@ -558,10 +620,188 @@ void step() {
     else
       nu *= *(it++);
 
-    for(int k=0; k<columns; k++)
-      n2->net[k] += nu * (data[id].val[k] - n2->net[k]);
+    f(*n2, nu);
+    }
+  }
+
+vector<int> batch_ids, batch_winners, batch_count;
+vector<double> batch_sum, batch_num, batch_den;
+
+/** an entry of a neighborhood, as visited by for_neighborhood: the neuron, its distance, and its index in the dispersion vector */
+struct hood_entry { int id; int dist; int disp; };
+
+/** in batch training, the neurons whose learning factor nu is below this are not updated (-som-hood-threshold) */
+double hood_threshold = 1e-5;
+
+/** at most this many entries are kept in hoods; the cache is cleared when it would grow beyond that (-som-hood-cache) */
+int hood_cache_limit = 1<<22;
+
+/** hoods[n] lists the part of the neighborhood of net[n] up to hood_cut[n] (see crawler_cut). The neighborhoods only shrink
+ *  as t decreases, so a neighborhood is usually computed once, at its first use, and then reused
+ */
+vector<vector<hood_entry>> hoods;
+vector<int> hood_crawler, hood_cut;
+int hood_cache_size;
+
+/** crawler_cut[cid] is (t, cut), where cut bounds the indices of the entries of crawler cid with nu at least hood_threshold
+ *  at that t: the indices to data for the gaussian neighborhoods, and to the dispersion vector otherwise
+ */
+vector<pair<int, int>> crawler_cut;
+
+int get_crawler_cut(int cid, double sigma, int dispid) {
+  if(isize(crawler_cut) <= cid) crawler_cut.resize(cid+1, make_pair(-1, 0));
+  auto& cc = crawler_cut[cid];
+  if(cc.first == t) return cc.second;
+  cc = make_pair(t, 0);
+  cellcrawler& s = scc[cid];
+  if(gaussian) {
+    for(int i=0; i<isize(s.data); i++)
+      if(learning_factor * exp(-sqr(s.data[i].dist/sigma)) >= hood_threshold) cc.second = i+1;
+    }
+  else {
+    auto& d = s.dispersion[dispid];
+    for(int i=0; i<isize(d); i++)
+      if(learning_factor * d[i] >= hood_threshold) cc.second = i+1;
+    }
+  return cc.second;
+  }
+
+vector<hood_entry>& get_hood(int n, double sigma, int dispid) {
+  if(isize(hoods) != isize(net)) {
+    hoods.clear(); hoods.resize(isize(net));
+    hood_crawler.assign(isize(net), -1); hood_cut.assign(isize(net), 0);
+    hood_cache_size = 0;
+    }
+  auto& h = hoods[n];
+  if(hood_crawler[n] == -1) hood_crawler[n] = get_cellcrawler_id(net[n].where).first;
+  int cut = get_crawler_cut(hood_crawler[n], sigma, dispid);
+  if(hood_cut[n] < cut) {
+    if(hood_cache_size + cut > hood_cache_limit) {
+      for(auto& h1: hoods) vector<hood_entry>().swap(h1);
+      hood_cut.assign(isize(net), 0);
+      hood_cache_size = 0;
+      }
+    auto cid = get_cellcrawler_id(net[n].where);
+    cellcrawler& s = scc[cid.first];
+    s.sprawl(cellwalker(net[n].where, cid.second));
+    hood_cache_size -= isize(h);
+    h.clear();
+    for(int i=0; i<isize(s.data); i++) {
+      if(gaussian ? i >= cut : isize(h) >= cut) break;
+      neuron *n2 = getNeuron(s.data[i].target.at);
+      if(n2) h.push_back(hood_entry{neuronId(*n2), s.data[i].dist, isize(h)});
+      }
+    h.shrink_to_fit();
+    hood_cut[n] = cut;
+    hood_cache_size += isize(h);
+    }
+  return h;
+  }
+
+/** train on batch_size samples at once. The winners are found for all of them first, in parallel;
+ *  then every neuron n2 moves by sum(nu * (x - n2)) / max(1, sum(nu)) over the samples x of the batch, with nu as in step.
+ *  While the total nu is at most 1, this is the sum of the online updates; above that, n2 moves to the weighted
+ *  average of the samples, as in the batch SOM. The sums are split between the threads by columns, so the result
+ *  does not depend on the number of threads
+ */
+void batch_step(double sigma, int dispid) {
+  int B = min(batch_size, t);
+  int N = isize(net);
+  batch_ids.resize(B);
+  for(int& id: batch_ids) id = hrand(samples);
+  batch_winners.resize(B);
+  som_parallel(B, 16, [&] (int k, int a, int b) {
+    for(int i=a; i<b; i++) {
+      double bdiff = HUGE_VAL;
+      int bid = -1;
+      best_matching(&data[batch_ids[i]].val[0], 0, N, bdiff, bid);
+      batch_winners[i] = bid;
+      }
+    });
+  
+  whowon.resize(samples);
+  batch_count.assign(N, 0);
+  for(int i=0; i<B; i++) whowon[batch_ids[i]] = &net[batch_winners[i]], batch_count[batch_winners[i]]++;
+  
+  // the neighborhoods of the winners with their learning factors; sprawl changes the crawlers, so this is not threaded
+  vector<int> winners;
+  vector<vector<pair<int, double>>> nus(N);
+  batch_den.assign(N, 0);
+  for(int n=0; n<N; n++) if(batch_count[n]) {
+    winners.push_back(n);
+    auto& h = get_hood(n, sigma, dispid);
+    auto& disp = scc[hood_crawler[n]].dispersion;
+    for(auto& e: h) {
+      double nu = learning_factor;
+      if(gaussian)
+        nu *= exp(-sqr(e.dist/sigma));
+      else
+        nu *= disp[dispid][e.disp];
+      if(nu < hood_threshold) continue;
+      nus[n].emplace_back(e.id, nu);
+      batch_den[e.id] += nu * batch_count[n];
+      }
     }
   
+  batch_sum.assign(N * columns, 0);
+  batch_num.assign(N * columns, 0);
+  som_parallel(columns, 1, [&] (int k, int k0, int k1) {
+    for(int i=0; i<B; i++) {
+      const double *x = &data[batch_ids[i]].val[0];
+      double *sum = &batch_sum[batch_winners[i] * columns];
+      for(int c=k0; c<k1; c++) sum[c] += x[c];
+      }
+    for(int n: winners) {
+      const double *sum = &batch_sum[n * columns];
+      for(auto& p: nus[n]) {
+        double *num = &batch_num[p.first * columns];
+        double nu = p.second;
+        for(int c=k0; c<k1; c++) num[c] += nu * sum[c];
+        }
+      }
+    for(int n=0; n<N; n++) if(batch_den[n]) {
+      double *num = &batch_num[n * columns];
+      double den = batch_den[n], div = max(den, 1.);
+      for(int c=k0; c<k1; c++) net[n].net[c] += (num[c] - den * net[n].net[c]) / div;
+      }
+    });
+  
+  t -= B;
+  if(t == 0) analyze();
+  }
+
+void step() {
+
+  if(t == 0) return;
+  sominit(2);
+  
+  double sigma;
+  int dispid;
+  schedule(sigma, dispid);
+  
+  if(batch_size > 1) { batch_step(sigma, dispid); return; }
+
+  int id = hrand(samples);
+  neuron& n = winner(id);
+  whowon.resize(samples);
+  whowon[id] = &n;
+    
+  /* 
+  for(neuron& n2: net) {
+    int d = celldistance(n.where, n2.where);
+    double nu = learning_factor; 
+//  nu *= exp(-t*(double)maxdist/perdist);
+//  nu *= exp(-t/t2);
+    nu *= exp(-sqr(d/sigma));
+    for(int k=0; k<columns; k++)
+      n2.net[k] += nu * (irisdata[id][k] - n2.net[k]);
+    } */
+    
+  for_neighborhood(n, sigma, dispid, [&] (neuron& n2, double nu) {
+    for(int k=0; k<columns; k++)
+      n2.net[k] += nu * (data[id].val[k] - n2.net[k]);
+    });
+  
   t--;
   if(t == 0) analyze();
   }
@@ -717,6 +957,8 @@ void sominit(int initto, bool load_compressed) {
     dispersion_count = 0;  
     
     scc.clear();
+    hoods.clear();
+    crawler_cut.clear();
     for(int i=0; i<cells; i++) {
       cell *c = net[i].where;
       auto cid = get_cellcrawler_id(c);
@@ -1005,13 +1247,25 @@ void do_classify() {
     printf("Classifying...\n");
     bids.resize(samples, 0);
     bdiffs.resize(samples, 1e20);
-    for(int s=0; s<samples; s++) {
-      for(int n=0; n<cells; n++) {
-        double diff = vnorm(net[n].net, data[s].val);
-        if(diff < bdiffs[s]) bdiffs[s] = diff, bids[s] = n, whowon[s] = &net[n];
-        }
-      if(!(s % 128))
-        progress("Classifying: " + its(s) + "/" + its(samples));
+    // the neurons are split into transposed tiles which fit in the cache; for each tile, the samples are split between the threads
+    const int tile = 256, chunk = 4096;
+    vector<vector<double>> tiles;
+    for(int n0=0; n0<cells; n0 += tile) {
+      int q = min(tile, cells - n0);
+      tiles.emplace_back(columns * q);
+      for(int j=0; j<q; j++) for(int k=0; k<columns; k++) tiles.back()[k*q+j] = net[n0+j].net[k];
+      }
+    for(int s0=0; s0<samples; s0 += chunk) {
+      int s1 = min(samples, s0 + chunk);
+      som_parallel(s1 - s0, 64, [&] (int k, int a, int b) {
+        for(int n0=0; n0<cells; n0 += tile)
+        for(int s=s0+a; s<s0+b; s++) {
+          int bid = -1;
+          best_matching_tile(&data[s].val[0], &tiles[n0/tile][0], n0, min(tile, cells - n0), bdiffs[s], bid);
+          if(bid != -1) bids[s] = bid;
+          }
+        });
+      progress("Classifying: " + its(s1) + "/" + its(samples));
       }
     }
   if(bdiffs.empty()) {
@@ -1438,6 +1692,18 @@ int readArgs() {
     PHASE(3);
     shift(); kohonen::kloadw(args());
     }
+  else if(argis("-som-threads")) {
+    shift(); som_threads = argi();
+    }
+  else if(argis("-som-batch")) {
+    shift(); batch_size = argi();
+    }
+  else if(argis("-som-hood-threshold")) {
+    shift_arg_formula(hood_threshold);
+    }
+  else if(argis("-som-hood-cache")) {
+    shift(); hood_cache_limit = argi();
+    }
   else if(argis("-somclassify0")) {
     PHASE(3);
     shift(); kohonen::do_classify();
@@ -1535,6 +1801,8 @@ void clear() {
   whowon.clear();
   samples_to_show.clear();
   scc.clear();
+  hoods.clear();
+  crawler_cut.clear();
   bdiffs.clear();
   bids.clear();
   bdiffn.clear();
@@ -1579,13 +1579,13 @@ bool rogueviz_hud() {
 void drawExtra() {
   
   if(kind == kFullNet) {
-    for(map<cell*, transmatrix>::iterator it = gmatrix.begin(); it != gmatrix.end(); it++) {
+    for(auto it = gmatrix.begin(); it != gmatrix.end(); it++) {
       cell *c = it->first;
       c->wall = waChasm;
       }
     int index = 0;
 
-    for(map<cell*, transmatrix>::iterator it = gmatrix.begin(); it != gmatrix.end(); it++) {
+    for(auto it = gmatrix.begin(); it != gmatrix.end(); it++) {
       cell *c = it->first;
       bool draw = true;
       for(int i=0; i<isize(named); i++) if(named[i] == c) draw = false;
@@ -198,13 +198,17 @@ hyperpoint hyperboloid_to_azeq(hyperpoint h) {
     }
   }
 
-struct normalizer {
+/** like normalizer, but the native geometry must be already set; does not change global state,
+ *  so it can be used in threads
+ */
+struct native_normalizer {
 
   transmatrix M, Mi;
-  
-  dynamicval<eGeometry> gw;
- 
-  normalizer (hyperpoint h1, hyperpoint h2) : gw(geometry, gwhere == gElliptic ? gSphere : gwhere) {
+
+  native_normalizer() {}
+  native_normalizer(hyperpoint h1, hyperpoint h2) { set(h1, h2); }
+
+  void set(hyperpoint h1, hyperpoint h2) {
     M = orthonormalize(h1, h2);
     Mi = inverse(M);
     }
@@ -213,6 +217,15 @@ struct normalizer {
   hyperpoint operator[] (hyperpoint h) { return M*hyperboloid_to_azeq(h); }
   };
 
+struct normalizer : native_normalizer {
+
+  dynamicval<eGeometry> gw;
+ 
+  normalizer (hyperpoint h1, hyperpoint h2) : gw(geometry, gwhere == gElliptic ? gSphere : gwhere) {
+    set(h1, h2);
+    }
+  };
+
 void push_point(hyperpoint& h, int coord, ld val) {
   if(fast_euclidean && gwhere == gEuclid) 
     h[coord] += val;
@@ -236,6 +249,30 @@ EX void push_all_points(int coord, ld val) {
 
 int hyprand;
 
+/** rug points whose h differ by less than this (squared) are identified by findRugpoint */
+const ld rugpoint_identify = 1e-5;
+
+/** the index of rug points used by findRugpoint: the first three coordinates of h are quantized to bins of this size,
+ *  which is larger than the identification distance, so only the neighboring bins need to be searched
+ */
+const ld rugpoint_bin_size = 4e-3;
+
+typedef array<long long, 3> rugpoint_bin;
+
+/** the points added by addRugpoint since the last clear_model or buildRug, by their bins */
+hashtable<rugpoint_bin, vector<rugpoint*>> point_bins;
+
+rugpoint_bin get_rugpoint_bin(const hyperpoint& h) {
+  rugpoint_bin res;
+  for(int i=0; i<3; i++) res[i] = (long long) floor(h[i] / rugpoint_bin_size);
+  return res;
+  }
+
+void rebin_rugpoints() {
+  point_bins.clear();
+  for(auto p: points) point_bins[get_rugpoint_bin(p->h)].push_back(p);
+  }
+
 EX rugpoint *addRugpoint(hyperpoint h, double dist) {
   rugpoint *m = new rugpoint;
   m->h = h;
@@ -339,12 +376,18 @@ EX rugpoint *addRugpoint(hyperpoint h, double dist) {
   m->inqueue = false;
   m->dist = dist;
   points.push_back(m);
+  point_bins[get_rugpoint_bin(m->h)].push_back(m);
   return m;
   }
 
 EX rugpoint *findRugpoint(hyperpoint h) {
-  for(int i=0; i<isize(points); i++) 
-    if(sqhypot_d(rugdim, points[i]->h - h) < 1e-5) return points[i];
+  rugpoint_bin b = get_rugpoint_bin(h), b1;
+  for(int dx=-1; dx<=1; dx++) for(int dy=-1; dy<=1; dy++) for(int dz=-1; dz<=1; dz++) {
+    b1[0] = b[0] + dx; b1[1] = b[1] + dy; b1[2] = b[2] + dz;
+    auto it = point_bins.find(b1);
+    if(it != point_bins.end()) for(auto p: it->second)
+      if(sqhypot_d(rugdim, p->h - h) < rugpoint_identify) return p;
+    }
   return NULL;
   }
 
@@ -386,7 +429,7 @@ EX void addTriangle(rugpoint *t1, rugpoint *t2, rugpoint *t3, ld len IS(1)) {
   triangles.push_back(triangle(t1,t2,t3));
   }
 
-map<pair<rugpoint*, rugpoint*>, rugpoint*> halves;
+hashtable<pair<rugpoint*, rugpoint*>, rugpoint*> halves;
 
 rugpoint* findhalf(rugpoint *r1, rugpoint *r2) {
   if(r1 > r2) swap(r1, r2);
@@ -676,6 +719,8 @@ EX void buildRug() {
     return;
     }
   
+  rebin_rugpoints();
+
   celllister cl(centerover.at ? centerover.at : cwt.at, get_sightrange(), vertex_limit, NULL);
 
   map<cell*, rugpoint *> vptr;
@@ -900,6 +945,8 @@ EX void optimize(rugpoint *m, bool do_preset) {
 
 int divides = 0;
 bool stop = false;
+/** the edges used by the Jacobi sweeps need to be rebuilt (see build_jacobi_edges) */
+bool jacobi_stale = true;
 
 EX bool subdivide_further() {
   if(fulltorus) return false;
@@ -1029,6 +1076,7 @@ int detect_cusp_at(rugpoint *p, rugpoint *q) {
     return 1;
   else {
     add_anticusp_edge(p, q);
+    jacobi_stale = true;
     enqueue(p);
     enqueue(q);
     return 2;
@@ -1106,6 +1154,240 @@ EX void addNewPoints() {
   if(qvalid != oqvalid) { println(hlog, "adding new points ", make_tuple(oqvalid, qvalid, isize(points), dist, dt, queueiter)); }
   }
 
+/** the solver used by physics: false for the queue of moved points, where the forces of the edges
+ *  of a point are applied immediately; true for Jacobi sweeps, where all the edges compute their
+ *  displacements from the same positions, and each point then moves by the average of its displacements
+ */
+EX bool jacobi_physics = false;
+
+/** number of threads used by the Jacobi sweeps */
+EX int physics_threads = 1;
+
+/** the average displacement is multiplied by this factor in the Jacobi sweeps (over-relaxation; must be below 2) */
+EX ld jacobi_relaxation = 1.5;
+
+EX int jacobi_sweeps;
+
+/** an edge used by the Jacobi sweeps, as indices to jacobi_points */
+struct jacobi_edge {
+  int a, b;
+  /** the rest length, or NULL for an anticusp edge, whose rest length is anticusp_dist */
+  const ld *len;
+  };
+
+/** the displacements computed by one thread */
+struct jacobi_accumulator {
+  vector<hyperpoint> delta;
+  vector<int> count;
+  ld error;
+  /** the largest amount by which an edge was off */
+  ld deviation;
+  bool moved;
+  };
+
+/** the valid points and the edges between them; rebuilt when the points, edges or their validity change */
+vector<rugpoint*> jacobi_points;
+vector<jacobi_edge> jacobi_edges;
+vector<jacobi_accumulator> jacobi_acc;
+int jacobi_qvalid;
+/** the largest amount by which an edge was off in the last sweep; no sweep is needed while it stays below err_zero_current */
+ld jacobi_deviation;
+
+void build_jacobi_edges() {
+  jacobi_points.clear();
+  jacobi_edges.clear();
+  hashtable<rugpoint*, int> id;
+  for(auto p: points) if(p->valid) id[p] = isize(jacobi_points), jacobi_points.push_back(p);
+  for(int i=0; i<isize(jacobi_points); i++) {
+    rugpoint *p = jacobi_points[i];
+    for(auto& e: p->edges) 
+      if(p < e.target && id.count(e.target)) jacobi_edges.push_back(jacobi_edge{i, id[e.target], &e.len});
+    for(auto& e: p->anticusp_edges) 
+      if(p < e.target && id.count(e.target)) jacobi_edges.push_back(jacobi_edge{i, id[e.target], nullptr});
+    }
+  jacobi_stale = false;
+  jacobi_qvalid = qvalid;
+  jacobi_deviation = HUGE_VAL;
+  }
+
+/** the displacements caused by the edges from i0 to i1, in the fast Euclidean case; the edges are processed in blocks,
+ *  with the coordinates gathered into arrays, so that the compiler can vectorize the computation
+ */
+void jacobi_range_euclidean(int i0, int i1, jacobi_accumulator& acc) {
+  const int BLOCK = 64;
+  int dims = min(rugdim, MAXMDIM);
+  ld d[MAXMDIM][BLOCK], t[BLOCK], rd[BLOCK], f[BLOCK];
+  bool skip[BLOCK];
+  for(int i=i0; i<i1; i+=BLOCK) {
+    int q = min(BLOCK, i1-i);
+    const jacobi_edge *je = &jacobi_edges[i];
+    for(int j=0; j<q; j++) rd[j] = je[j].len ? *je[j].len : anticusp_dist;
+    for(int k=0; k<dims; k++) for(int j=0; j<q; j++)
+      d[k][j] = jacobi_points[je[j].b]->flat[k] - jacobi_points[je[j].a]->flat[k];
+    for(int j=0; j<q; j++) t[j] = 0;
+    for(int k=0; k<dims; k++) for(int j=0; j<q; j++) t[j] += d[k][j] * d[k][j];
+    for(int j=0; j<q; j++) {
+      skip[j] = !je[j].len && t[j] > rd[j] * rd[j];
+      t[j] = sqrt(t[j]);
+      f[j] = (t[j] - rd[j]) / t[j] / 2;
+      }
+    for(int j=0; j<q; j++) {
+      if(skip[j]) continue;
+      acc.error += (t[j]-rd[j]) * (t[j]-rd[j]);
+      acc.deviation = max(acc.deviation, abs(t[j]-rd[j]));
+      if(abs(t[j]-rd[j]) > err_zero_current) acc.moved = true;
+      for(int k=0; k<dims; k++) {
+        acc.delta[je[j].a][k] += d[k][j] * f[j];
+        acc.delta[je[j].b][k] -= d[k][j] * f[j];
+        }
+      acc.count[je[j].a]++; acc.count[je[j].b]++;
+      }
+    }
+  }
+
+/** the displacements caused by the edges from i0 to i1, computed as in force; the native geometry must be set */
+void jacobi_range(int i0, int i1, jacobi_accumulator& acc) {
+  for(int i=i0; i<i1; i++) {
+    auto& je = jacobi_edges[i];
+    hyperpoint& h1 = jacobi_points[je.a]->flat;
+    hyperpoint& h2 = jacobi_points[je.b]->flat;
+    ld rd = je.len ? *je.len : anticusp_dist;
+    native_normalizer n(h1, h2);
+    hyperpoint f1 = n(h1);
+    hyperpoint f2 = n(h2);
+    ld t = hdist(f1, f2);
+    if(!je.len && t > rd) continue;
+    acc.error += (t-rd) * (t-rd);
+    acc.deviation = max(acc.deviation, abs(t-rd));
+    if(abs(t-rd) > err_zero_current) acc.moved = true;
+    ld forcev = (t - rd) / 2;
+    transmatrix T = gpushxto0(f1);
+    transmatrix iT1 = inverse(spintox(T * f2) * T);
+    acc.delta[je.a] += n[iT1 * xpush0(forcev)] - h1;
+    acc.delta[je.b] += n[iT1 * xpush0(t-forcev)] - h2;
+    acc.count[je.a]++; acc.count[je.b]++;
+    }
+  }
+
+/** one Jacobi sweep over jacobi_edges; returns true if some edge is still off by more than err_zero_current */
+bool jacobi_sweep() {
+  int N = isize(jacobi_edges), P = isize(jacobi_points);
+  int qty = 1;
+  #if CAP_THREAD
+  qty = max(1, min(physics_threads, N / 256));
+  #endif
+  jacobi_acc.resize(qty);
+  for(auto& acc: jacobi_acc) {
+    acc.delta.assign(P, Hypc);
+    acc.count.assign(P, 0);
+    acc.error = 0;
+    acc.deviation = 0;
+    acc.moved = false;
+    }
+  
+  USING_NATIVE_GEOMETRY;
+  auto range = (gwhere == gEuclid && fast_euclidean) ? jacobi_range_euclidean : jacobi_range;
+  #if CAP_THREAD
+  if(qty > 1) {
+    vector<std::thread> v;
+    for(int k=1; k<qty; k++)
+      v.emplace_back([=] { range(N*k/qty, N*(k+1)/qty, jacobi_acc[k]); });
+    range(0, N/qty, jacobi_acc[0]);
+    for(auto& t: v) t.join();
+    }
+  else
+  #endif
+  range(0, N, jacobi_acc[0]);
+  
+  bool moved = false;
+  ld error = 0;
+  jacobi_deviation = 0;
+  for(int k=0; k<qty; k++) {
+    auto& acc = jacobi_acc[k];
+    moved |= acc.moved;
+    error += acc.error;
+    jacobi_deviation = max(jacobi_deviation, acc.deviation);
+    if(k) for(int i=0; i<P; i++) jacobi_acc[0].delta[i] += acc.delta[i], jacobi_acc[0].count[i] += acc.count[i];
+    }
+  
+  auto& acc = jacobi_acc[0];
+  for(int i=0; i<P; i++) if(acc.count[i]) {
+    hyperpoint& h = jacobi_points[i]->flat;
+    h += acc.delta[i] * (jacobi_relaxation / acc.count[i]);
+    for(int j=0; j<3; j++) if(std::isnan(h[j])) {
+      addMessage("Failed!");
+      throw rug_exception();
+      }
+    }
+  
+  current_total_error = error;
+  jacobi_sweeps++;
+  return moved;
+  }
+
+/** the sum of squared errors of the edges between valid points */
+EX ld total_error() {
+  ld err = 0;
+  for(auto p: points) if(p->valid) for(auto& e: p->edges) if(p < e.target && e.target->valid) {
+    ld t = (gwhere == gEuclid && fast_euclidean) ? hypot_d(rugdim, p->flat - e.target->flat) : modeldist(p->flat, e.target->flat);
+    err += (t - e.len) * (t - e.len);
+    }
+  return err;
+  }
+
+/** some work of the physics: one Jacobi sweep, or up to 50 points from the queue; returns false if there
+ *  was nothing to do, i.e., the model has converged for the current points and precision
+ */
+bool physics_step() {
+  if(jacobi_physics) {
+    if(jacobi_stale || jacobi_qvalid != qvalid) build_jacobi_edges();
+    else if(jacobi_deviation <= err_zero_current) return false;
+    if(!jacobi_sweep()) return false;
+    need_mouseh = true;
+    return true;
+    }
+
+  if(!jacobi_stale) {
+    // switched back from the Jacobi sweeps, which do not keep the queue
+    jacobi_stale = true;
+    for(auto p: points) enqueue(p);
+    }
+
+  if(pqueue.empty()) return false;
+  for(int it=0; it<50 && !pqueue.empty(); it++) {
+    queueiter++;
+    rugpoint *m = pqueue.front();
+    pqueue.pop();
+    m->inqueue = false;
+    bool moved = false;
+    
+    for(auto& e: m->edges)
+      moved = force(*m, *e.target, e.len) || moved;
+    
+    for(auto& e: m->anticusp_edges)
+      moved = force(*m, *e.target, anticusp_dist, true) || moved;
+    
+    if(moved) enqueue(m), need_mouseh = true;
+    }
+  return true;
+  }
+
+/** addNewPoints; the Jacobi edges become stale only if it has subdivided the model, since a change in qvalid is
+ *  noticed by physics_step, and the anticusp edges mark them stale themselves
+ */
+void add_new_points() {
+  int N = isize(points);
+  addNewPoints();
+  if(isize(points) != N) jacobi_stale = true;
+  }
+
+/** the Jacobi sweeps have nothing more to do: all the points have been added at the final resolution, and no edge
+ *  was off by more than err_zero in the last sweep
+ */
+bool jacobi_converged() {
+  return !jacobi_stale && jacobi_qvalid == qvalid && qvalid == isize(points) && !subdivide_further() && jacobi_deviation <= err_zero;
+  }
+
 EX void physics() {
 
   #if CAP_CRYSTAL
@@ -1116,30 +1398,34 @@ EX void physics() {
   #endif
 
   if(good_shape) return;
+  
+  if(jacobi_physics && jacobi_converged()) return;
 
   auto t = SDL_GetTicks();
   
   current_total_error = 0;
   
   while(SDL_GetTicks() < t + 5 && !stop)
-  for(int it=0; it<50 && !stop; it++)
-    if(pqueue.empty()) addNewPoints();
-    else {
-      queueiter++;
-      rugpoint *m = pqueue.front();
-      pqueue.pop();
-      m->inqueue = false;
-      bool moved = false;
-      
-      for(auto& e: m->edges)
-        moved = force(*m, *e.target, e.len) || moved;
-      
-      for(auto& e: m->anticusp_edges)
-        moved = force(*m, *e.target, anticusp_dist, true) || moved;
-      
-      if(moved) enqueue(m), need_mouseh = true;
-      }    
+    if(!physics_step()) add_new_points();
+  }
 
+/** run the physics without the frame time budget, until the model has all its points, the final resolution,
+ *  and no edge off by more than err_zero; or until limit_ms milliseconds pass. Returns true if it has converged.
+ */
+EX bool relax(int limit_ms) {
+  err_zero_current = min(err_zero_current, err_zero);
+  auto t = SDL_GetTicks();
+  while(!good_shape && !stop) {
+    current_total_error = 0;
+    if(physics_step()) ;
+    else if(qvalid == isize(points) && !subdivide_further()) {
+      if(!anticusp_factor || !detect_cusps()) return true;
+      jacobi_stale = true;
+      }
+    else add_new_points();
+    if(SDL_GetTicks() >= t + limit_ms) return false;
+    }
+  return true;
   }
 
 // drawing the Rug
@@ -1476,6 +1762,44 @@ EX void reopen() {
   if(!rugged) return;
   }
 
+/** what the model was built from; load_model rejects a file whose signature differs from the current one.
+ *  The modelscale here is the one before building, since buildTorusRug computes its own
+ */
+struct rug_signature {
+  int geometry, variation, vertex_limit, sightrange, gwhere, rugdim, cells;
+  ld modelscale;
+  /** a hash of the distances and the screen positions of the source cells */
+  unsigned long long source_hash;
+  bool operator == (const rug_signature& s) const {
+    return geometry == s.geometry && variation == s.variation && vertex_limit == s.vertex_limit && sightrange == s.sightrange
+      && gwhere == s.gwhere && rugdim == s.rugdim && cells == s.cells && modelscale == s.modelscale && source_hash == s.source_hash;
+    }
+  };
+
+/** the signature of the current model, computed by init_model before building or loading it */
+rug_signature model_signature;
+
+/** the signature of a model which init_model would build now, from the map drawn by drawthemap */
+rug_signature current_signature() {
+  rug_signature sig;
+  sig.geometry = (int) geometry; sig.variation = (int) variation;
+  sig.vertex_limit = vertex_limit; sig.sightrange = get_sightrange();
+  sig.gwhere = (int) gwhere; sig.rugdim = rugdim; sig.modelscale = modelscale;
+  celllister cl(centerover.at ? centerover.at : cwt.at, get_sightrange(), vertex_limit, NULL);
+  sig.cells = isize(cl.lst);
+  size_t h = 0;
+  auto mix = [&h] (long long x) { h = hashtable_hash(make_pair((unsigned long long) h, (unsigned long long) x)); };
+  for(int i=0; i<isize(cl.lst); i++) {
+    hyperpoint onscreen;
+    applymodel(ggmatrix(cl.lst[i]) * C0, onscreen);
+    mix(cl.dists[i]);
+    mix(llround((1 + onscreen[0] * vid.scale) / 2 * 1e6));
+    mix(llround((1 - onscreen[1] * vid.scale) / 2 * 1e6));
+    }
+  sig.source_hash = h;
+  return sig;
+  }
+
 EX bool display_warning = true;
 
 EX void init_model() {
@@ -1495,6 +1819,13 @@ EX void init_model() {
     return;
     }
   #endif
+
+  model_signature = current_signature();
+  if(model_file != "" && load_model(model_file)) {
+    println(hlog, "loaded the rug model from ", model_file, ": ", isize(points), " points");
+    currentrot = Id;
+    return;
+    }
   
   try {
     buildRug();
@@ -1534,7 +1865,148 @@ EX void clear_model() {
   triangles.clear();
   for(int i=0; i<isize(points); i++) delete points[i];
   points.clear();
+  point_bins.clear();
   pqueue = queue<rugpoint*> ();
+  jacobi_stale = true;
+  }
+
+/** if set, init_model loads the model from this file instead of building it, if possible */
+EX string model_file;
+
+/** the file format of save_model: a header, then the arrays of rug_file_point, the edges, the anticusp edges,
+ *  and the triangles, each stored as its size and its raw contents, so they are read in one go
+ */
+const int rug_file_magic = 0x47555248; /* "HRUG" */
+const int rug_file_version = 2;
+
+void write_signature(hstream& f, const rug_signature& sig) {
+  f.write(sig.geometry); f.write(sig.variation); f.write(sig.vertex_limit); f.write(sig.sightrange);
+  f.write(sig.gwhere); f.write(sig.rugdim); f.write(sig.cells); f.write(sig.modelscale); f.write(sig.source_hash);
+  }
+
+void read_signature(hstream& f, rug_signature& sig) {
+  f.read(sig.geometry); f.read(sig.variation); f.read(sig.vertex_limit); f.read(sig.sightrange);
+  f.read(sig.gwhere); f.read(sig.rugdim); f.read(sig.cells); f.read(sig.modelscale); f.read(sig.source_hash);
+  }
+
+struct rug_file_point {
+  double h[MAXMDIM], flat[MAXMDIM];
+  double x1, y1, dist;
+  int glue;
+  int valid;
+  };
+
+struct rug_file_edge {
+  int a, b;
+  double len;
+  };
+
+template<class T> void write_raw_vector(hstream& f, const vector<T>& v) {
+  f.write<int>(isize(v));
+  if(!v.empty()) f.write_chars((const char*) &v[0], sizeof(T) * v.size());
+  }
+
+/** the number of bytes left to read in f */
+long long bytes_left(fhstream& f) {
+  long pos = ftell(f.f);
+  if(pos < 0 || fseek(f.f, 0, SEEK_END)) throw hstream_exception();
+  long end = ftell(f.f);
+  if(end < 0 || fseek(f.f, pos, SEEK_SET)) throw hstream_exception();
+  return end - pos;
+  }
+
+template<class T> void read_raw_vector(fhstream& f, vector<T>& v) {
+  int q = f.get<int>();
+  if(q < 0 || (long long) sizeof(T) * q > bytes_left(f)) throw hstream_exception();
+  v.resize(q);
+  if(q) f.read_chars((char*) &v[0], sizeof(T) * q);
+  }
+
+/** save the current model, with the positions, edges and triangles, so that it can be loaded with load_model */
+EX bool save_model(const string& fname) {
+  fhstream f(fname, "wb");
+  if(!f.f) return false;
+  hashtable<rugpoint*, int> id;
+  for(int i=0; i<isize(points); i++) id[points[i]] = i;
+  vector<rug_file_point> fp(isize(points));
+  vector<rug_file_edge> fe, fa;
+  vector<array<int, 3>> ft;
+  for(int i=0; i<isize(points); i++) {
+    rugpoint *p = points[i];
+    auto& q = fp[i];
+    for(int j=0; j<MAXMDIM; j++) q.h[j] = p->h[j], q.flat[j] = p->flat[j];
+    q.x1 = p->x1; q.y1 = p->y1; q.dist = p->dist;
+    q.glue = p->glue ? id[p->glue] : -1;
+    q.valid = p->valid;
+    for(auto& e: p->edges) fe.push_back(rug_file_edge{i, id[e.target], e.len});
+    for(auto& e: p->anticusp_edges) fa.push_back(rug_file_edge{i, id[e.target], e.len});
+    }
+  for(auto& t: triangles) ft.push_back(make_array(id[t.m[0]], id[t.m[1]], id[t.m[2]]));
+  try {
+    f.write(rug_file_magic); f.write(rug_file_version);
+    write_signature(f, model_signature);
+    f.write(good_shape); f.write(modelscale); f.write(err_zero_current); f.write(anticusp_dist);
+    write_raw_vector(f, fp);
+    write_raw_vector(f, fe);
+    write_raw_vector(f, fa);
+    write_raw_vector(f, ft);
+    }
+  catch(hstream_exception&) { return false; }
+  return true;
+  }
+
+/** load a model saved with save_model; the physics then continues from the saved state */
+EX bool load_model(const string& fname) {
+  fhstream f(fname, "rb");
+  if(!f.f) return false;
+  vector<rug_file_point> fp;
+  vector<rug_file_edge> fe, fa;
+  vector<array<int, 3>> ft;
+  rug_signature sig;
+  bool gs;
+  ld ms, ez, ad;
+  try {
+    if(f.get<int>() != rug_file_magic || f.get<int>() != rug_file_version) return false;
+    read_signature(f, sig);
+    if(!(sig == model_signature)) {
+      println(hlog, "the rug model in ", fname, " was built from a different map or different settings");
+      return false;
+      }
+    f.read(gs); f.read(ms); f.read(ez); f.read(ad);
+    read_raw_vector(f, fp);
+    read_raw_vector(f, fe);
+    read_raw_vector(f, fa);
+    read_raw_vector(f, ft);
+    }
+  catch(hstream_exception&) { return false; }
+  
+  int N = isize(fp);
+  auto valid_id = [N] (int i) { return i >= 0 && i < N; };
+  for(auto& q: fp) if(q.glue != -1 && !valid_id(q.glue)) return false;
+  for(auto& e: fe) if(!valid_id(e.a) || !valid_id(e.b)) return false;
+  for(auto& e: fa) if(!valid_id(e.a) || !valid_id(e.b)) return false;
+  for(auto& t: ft) for(int i: t) if(!valid_id(i)) return false;
+  
+  clear_model();
+  good_shape = gs;
+  modelscale = ms; err_zero_current = ez; anticusp_dist = ad;
+  qvalid = 0;
+  for(auto& q: fp) {
+    rugpoint *m = new rugpoint;
+    for(int j=0; j<MAXMDIM; j++) m->h[j] = q.h[j], m->flat[j] = q.flat[j];
+    m->x1 = q.x1; m->y1 = q.y1; m->dist = q.dist;
+    m->valid = q.valid;
+    if(m->valid) qvalid++;
+    m->inqueue = false;
+    points.push_back(m);
+    }
+  rebin_rugpoints();
+  for(int i=0; i<N; i++) if(fp[i].glue != -1) points[i]->glue = points[fp[i].glue];
+  for(auto& e: fe) points[e.a]->edges.push_back(edge{points[e.b], e.len});
+  for(auto& e: fa) points[e.a]->anticusp_edges.push_back(edge{points[e.b], e.len});
+  for(auto& t: ft) triangles.emplace_back(points[t[0]], points[t[1]], points[t[2]]);
+  for(auto p: points) enqueue(p);
+  return true;
   }
   
 EX void close() {
@@ -1627,7 +2099,7 @@ EX void finger_on(int coord, ld val) {
     ld d = hdist(finger_center->h, p->getglue()->h);
     push_point(p->flat, coord, val * finger_force * exp( - sqr(d / finger_range)));
     }
-  enqueue(finger_center), good_shape = false;
+  enqueue(finger_center), good_shape = false, jacobi_stale = true;
   }
 
 transmatrix last_orientation;
@@ -1893,7 +2365,7 @@ EX void show() {
     dialog::addSelItem(XLAT("radar"), radar_distance == RADAR_INF ? "∞" : fts(radar_distance, 4), 'r');
   dialog::addSelItem(XLAT("model scale factor"), fts(modelscale), 'm');
   if(rug::rugged)
-    dialog::addSelItem(XLAT("model iterations"), its(queueiter), 0);
+    dialog::addSelItem(XLAT("model iterations"), its(jacobi_physics ? jacobi_sweeps : queueiter), 0);
   dialog::addItem(XLAT("stereo vision config"), 'f');
   // dialog::addSelItem(XLAT("protractor"), fts(protractor * 180 / M_PI) + "°", 'f');
   if(!good_shape) {
@@ -1903,6 +2375,8 @@ EX void show() {
     }
   dialog::addSelItem(XLAT("automatic move speed"), fts(ruggo), 'G');
   dialog::addSelItem(XLAT("anti-crossing"), fts(anticusp_factor), 'A');
+  dialog::addBoolItem(XLAT("Jacobi sweeps"), jacobi_physics, 'J');
+  dialog::add_action([] () { jacobi_physics = !jacobi_physics; });
   dialog::addBoolItem(XLAT("3D monsters/walls on the surface"), spatial_rug, 'S');
   dialog::add_action([] () { spatial_rug = !spatial_rug; });
   edit_levellines('L');
@@ -1998,6 +2472,7 @@ EX void show() {
           if(adjust_distance) model_distance = model_distance * modelscale / last;
           last = modelscale;
           good_shape = false;
+          jacobi_stale = true;
           if(!camera_center) push_all_points(2, -model_distance);
           };
         }
@@ -2133,6 +2608,44 @@ int rugArgs() {
     shift_arg_formula(anticusp_factor);
     }
 
+  else if(argis("-rugjacobi")) {
+    shift(); jacobi_physics = argi();
+    }
+
+  else if(argis("-rugthreads")) {
+    shift(); physics_threads = argi();
+    }
+
+  else if(argis("-rugrelax")) {
+    shift_arg_formula(jacobi_relaxation);
+    }
+
+  else if(argis("-rugload")) {
+    shift(); model_file = args();
+    }
+
+  else if(argis("-rugsave")) {
+    PHASE(3); shift();
+    if(!save_model(args())) println(hlog, "failed to save the rug model to ", args());
+    }
+
+  else if(argis("-rugbatch")) {
+    // build the model (or resume it from the file), relax it for at most the given time, and save it to the file
+    PHASE(3); shift(); int limit = argi();
+    shift(); model_file = args();
+    calcparam();
+    rugdim = 2 * GDIM - 1;
+    init_model();
+    try {
+      bool converged = relax(limit);
+      println(hlog, converged ? "converged: " : "time limit reached: ", isize(points), " points, error ", total_error());
+      }
+    catch(rug_exception&) {
+      println(hlog, "the physics failed");
+      }
+    if(!save_model(model_file)) println(hlog, "failed to save the rug model to ", model_file);
+    }
+
   else if(argis("-d:rug")) 
     launch_dialog(show);
 
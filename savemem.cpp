@@ -17,10 +17,65 @@ EX bool memory_saving_mode = true;
 EX bool show_memory_warning = true;
 EX bool ignored_memory_warning;
 
+/** memory saving mode removes the regions at least this far behind the players */
 static const int LIM = 150;
 
+/** memory_budget never removes the regions closer than this */
+static const int MIN_LIM = 30;
+
 EX heptagon *last_cleared;
 
+/** the memory budget in bytes (-membudget), or 0 for none */
+EX long long memory_budget = 0;
+
+/** we are over memory_budget, and there was nothing more to remove; no new cells are generated then */
+EX bool memory_budget_exceeded;
+
+/** the warning about memory_budget_exceeded has been printed */
+bool memory_budget_warned;
+
+#if HDR
+/** the memory used by the world, in bytes */
+struct memory_usage_info {
+  long long cells, heptagons, cdata, arena, distances, geometry, monsters;
+  /** the memory used, counting the arena slabs as reserved, including the free slots */
+  long long total() const { return arena + distances + geometry + monsters; }
+  /** the memory used, counting only the live objects in the arenas */
+  long long live() const { return cells + heptagons + cdata + distances + geometry + monsters; }
+  };
+#endif
+
+EX memory_usage_info memory_usage() {
+  memory_usage_info m;
+  m.cells = cellbytes;
+  m.heptagons = heptabytes;
+  m.cdata = databytes;
+  m.arena = arenabytes;
+  m.distances = saved_distances_memory();
+  m.geometry = cgis_memory();
+  m.monsters = isize(shmup::monstersAt) * (long long) sizeof(shmup::monster) + 
+    isize(shmup::monstersAt.first) * (long long) (sizeof(pair<cell*, shmup::monster*>) + 2 * sizeof(int));
+  return m;
+  }
+
+/** parse a memory size such as 2G, 512M, 100000K or 5000000; returns the number of bytes, or -1 if s is not a valid size */
+EX long long parse_memory_size(const string& s) {
+  double val = 0;
+  int len = 0;
+  if(sscanf(s.c_str(), "%lf%n", &val, &len) != 1 || !(val >= 0)) return -1;
+  string unit = s.substr(len);
+  if(unit == "K" || unit == "k") val *= 1024;
+  else if(unit == "M" || unit == "m") val *= 1024 * 1024;
+  else if(unit == "G" || unit == "g") val *= 1024 * 1024 * 1024;
+  else if(unit != "") return -1;
+  if(val >= 9e18) return -1;
+  return (long long) val;
+  }
+
+EX string memory_size_string(long long bytes) {
+  return its(int(bytes >> 20)) + " MB";
+  }
+
 EX void destroycellcontents(cell *c) {
   c->land = laMemory;
   c->wall = waChasm;
@@ -46,7 +101,7 @@ void slow_delete_cell(cell *c) {
     if(c->move(i))
       c->move(i)->move(c->c.spin(i)) = NULL;
   removed_cells.push_back(c);
-  delete c;
+  tailored_delete(c);
   }
 
 void delete_heptagon(heptagon *h2) {
@@ -60,7 +115,8 @@ void delete_heptagon(heptagon *h2) {
   for(int i=0; i<S7; i++)
     if(h2->move(i))
       h2->move(i)->move(h2->c.spin(i)) = NULL;
-  delete h2;
+  if(h2->cdata) tailored_delete(h2->cdata);
+  tailored_delete(h2);
   }
 
 void recursive_delete(heptagon *h, int i) {
@@ -93,19 +149,34 @@ bool unsafeLand(cell *c) {
     among(c->land, laCaribbean, laOcean, laGraveyard, laPrincessQuest);
   }
 
-EX void save_memory() {
-  if(quotient || !hyperbolic || NONSTDVAR) return;
-  if(!memory_saving_mode) return;
-  if(unsafeLand(cwt.at)) return;
-  int d = celldist(cwt.at);
-  if(d < LIM+10) return;
+bool can_clear_behind() {
+  return !quotient && hyperbolic && !NONSTDVAR;
+  }
+
+/** Remove the regions which are at least lim behind all the players (and the Orb of Recall).
+ *  The regions removed are the subtrees hanging off the chain of move(0) ancestors of the
+ *  players; as the players go away from the origin, the regions further up the chain are
+ *  the ones they left the longest time ago.
+ */
+void clear_behind(int lim) {
+  vector<cell*> keep;
+  for(int i=0; i<numplayers(); i++)
+    if(multi::playerActive(i) && playerpos(i)) keep.push_back(playerpos(i));
+  if(keep.empty()) keep.push_back(cwt.at);
+  if(recallCell.at) keep.push_back(recallCell.at);
+
+  int d = celldist(keep[0]);
+  for(cell *c: keep) {
+    if(unsafeLand(c)) return;
+    d = min(d, celldist(c));
+    }
+  if(d < lim+10) return;
 
-  heptagon *at = cwt.at->master;
+  heptagon *at = keep[0]->master;
   heptagon *orig = currentmap->gamestart()->master;
   
-  if(recallCell.at) {
-    if(unsafeLand(recallCell.at)) return;
-    heptagon *at2 = recallCell.at->master;
+  for(cell *c: keep) {
+    heptagon *at2 = c->master;
     int t = 0;
     while(at != at2) {
       t++; if(t > 10000) return;
@@ -116,7 +187,7 @@ EX void save_memory() {
       }
     }
   
-  while(celldist(at->c7) > d-LIM) at = at->move(0);
+  while(celldist(at->c7) > d-lim) at = at->move(0);
   
   // go back to such a point X that all the heptagons adjacent to the current 'at'
   // are the children of X. This X becomes the new 'at'
@@ -171,6 +242,34 @@ EX void save_memory() {
   removed_cells.clear();
   }
 
+/** The arena slabs are never returned while the map exists, so once they reserve more than memory_budget, we
+ *  keep the live objects within memory_budget, so that new cells reuse the freed slots rather than new slabs. We remove
+ *  the saved distances, and then the regions closer and closer behind the players; if that is not possible or not
+ *  enough, we warn once, and stop generating new cells.
+ */
+void enforce_memory_budget() {
+  memory_budget_exceeded = false;
+  if(memory_usage().total() <= memory_budget || memory_usage().live() <= memory_budget) {
+    memory_budget_warned = false;
+    return;
+    }
+  erase_saved_distances();
+  if(can_clear_behind())
+    for(int lim = LIM; lim >= MIN_LIM && memory_usage().live() > memory_budget; lim -= 20)
+      clear_behind(lim);
+  if(memory_usage().live() <= memory_budget) return;
+  memory_budget_exceeded = true;
+  if(!memory_budget_warned) {
+    memory_budget_warned = true;
+    println(hlog, "memory budget exceeded: ", memory_size_string(memory_usage().total()), " used, ", memory_size_string(memory_budget), " allowed; no new cells will be generated");
+    }
+  }
+
+EX void save_memory() {
+  if(memory_saving_mode && can_clear_behind()) clear_behind(LIM);
+  if(memory_budget) enforce_memory_budget();
+  }
+
 EX purehookset hooks_removecells;
 
 EX bool is_cell_removed(cell *c) {
@@ -255,6 +354,10 @@ EX void show_memory_menu() {
   
   if(cheater) dialog::addSelItem(XLAT("cells in memory"), its(cellcount) + "+" + its(heptacount), 0);
   
+  if(cheater || memory_budget) dialog::addSelItem(XLAT("memory used"), memory_size_string(memory_usage().total()), 0);
+
+  if(memory_budget) dialog::addSelItem(XLAT("memory budget"), memory_size_string(memory_budget), 0);
+  
   dialog::addBoolItem(XLAT("memory saving mode"), memory_saving_mode, 'f');
   dialog::add_action([] { memory_saving_mode = !memory_saving_mode; if(memory_saving_mode) save_memory(), apply_memory_reserve(); });
 
@@ -285,6 +388,10 @@ EX void show_memory_menu() {
   }
 
 EX bool protect_memory() {
+  if(memory_budget_exceeded && !ignored_memory_warning) {
+    pushScreen(show_memory_menu);
+    return true;
+    }
   if(!CAP_MEMORY_RESERVE) return false;
   apply_memory_reserve();
   if(reserve_limit && reserve_count < reserve_limit && !ignored_memory_warning) {
@@ -299,7 +406,7 @@ EX bool protect_memory() {
   }
 
 EX bool memory_issues() {
-  return reserve_limit && reserve_count < 16;
+  return memory_budget_exceeded || (reserve_limit && reserve_count < 16);
   }
 
 }
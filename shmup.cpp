@@ -73,8 +73,13 @@ struct monster {
   double footphase;
   bool isVirtual;  // off the screen: gmatrix is unknown, and pat equals at
   hyperpoint inertia;// for frictionless lands
+  /** the next and previous monster in the list in monstersAt; prev_stored is NULL if not stored, and the first one points to the last one */
+  monster *next_stored, *prev_stored;
+  /** the cell under which this monster is stored in monstersAt */
+  cell *stored_at;
   
   monster() { 
+    next_stored = prev_stored = NULL; stored_at = NULL;
     dead = false; inBoat = false; parent = NULL; nextshot = 0; 
     stunoff = 0; blowoff = 0; footphase = 0; no_targetting = false;
     swordangle = 0; inertia = Hypc; if(prod) ori = Id;
@@ -103,12 +108,74 @@ EX bool delayed_safety = false;
 
 bool lastdead = false;
 
-EX multimap<cell*, monster*> monstersAt;
-
 #if HDR
-typedef multimap<cell*, monster*>::iterator mit;
+/** inactive monsters, kept in intrusive lists (via monster::next_stored), one list for each cell */
+struct monster_buckets {
+  /** the first monster in the list of each cell; NULL if that list has been emptied */
+  hashtable<cell*, monster*> first;
+  int qty;
+  monster_buckets() { qty = 0; }
+  /** the first monster stored at c, or NULL */
+  monster *at(cell *c) { auto it = first.find(c); return it == first.end() ? nullptr : it->second; }
+  void insert(cell *c, monster *m);
+  void erase(monster *m);
+  /** remove all the monsters stored at c, and append them to v */
+  void take(cell *c, vector<monster*>& v);
+  vector<monster*> all();
+  int size() const { return qty; }
+  bool empty() const { return qty == 0; }
+  void clear() { first.clear(); qty = 0; }
+  };
 #endif
 
+void monster_buckets::insert(cell *c, monster *m) {
+  monster*& h = first[c];
+  m->stored_at = c;
+  m->next_stored = NULL;
+  if(!h) h = m, m->prev_stored = m;
+  else {
+    monster *last = h->prev_stored;
+    last->next_stored = m; m->prev_stored = last; h->prev_stored = m;
+    }
+  qty++;
+  }
+
+void monster_buckets::erase(monster *m) {
+  monster*& h = first[m->stored_at];
+  if(m == h) {
+    h = m->next_stored;
+    if(h) h->prev_stored = m->prev_stored;
+    }
+  else {
+    m->prev_stored->next_stored = m->next_stored;
+    if(m->next_stored) m->next_stored->prev_stored = m->prev_stored;
+    else h->prev_stored = m->prev_stored;
+    }
+  m->next_stored = m->prev_stored = NULL;
+  qty--;
+  }
+
+void monster_buckets::take(cell *c, vector<monster*>& v) {
+  auto it = first.find(c);
+  if(it == first.end()) return;
+  for(monster *m = it->second; m;) {
+    monster *next = m->next_stored;
+    m->next_stored = m->prev_stored = NULL;
+    v.push_back(m); qty--;
+    m = next;
+    }
+  it->second = NULL;
+  }
+
+vector<monster*> monster_buckets::all() {
+  vector<monster*> res;
+  for(auto& p: first) 
+    for(monster *m = p.second; m; m = m->next_stored) res.push_back(m);
+  return res;
+  }
+
+EX monster_buckets monstersAt;
+
 vector<monster*> active, nonvirtual, additional;
 
 cell *findbaseAround(hyperpoint p, cell *around, int maxsteps) {
@@ -138,7 +205,8 @@ cell *findbaseAround(const transmatrix& H, cell *around, int maxsteps) {
   } */
 
 void monster::store() {
-  monstersAt.insert(make_pair(base, this));
+  if(prev_stored) monstersAt.erase(this);
+  monstersAt.insert(base, this);
   }
 
 void monster::findpat() {
@@ -175,20 +243,20 @@ void monster::rebasePat(const transmatrix& new_pat, cell *c2) {
     return;
     }
   if(quotient) {
-    at = inverse(gmatrix[base]) * new_pat;
+    at = iso_inverse(gmatrix[base]) * new_pat;
     virtualRebase(this, true);
     fix_to_2(at);
     if(base != c2) {
       auto T = calc_relative_matrix(c2, base, tC0(at));
       base = c2;
-      at = inverse(T) * at;
+      at = iso_inverse(T) * at;
       }
     return;
     }
   pat = new_pat;
   // if(c2 != base) printf("rebase %p -> %p\n", base, c2);
   base = c2;
-  at = inverse(gmatrix[c2]) * pat;
+  at = iso_inverse(gmatrix[c2]) * pat;
   fix_to_2(at);
   fixelliptic(at);
   }
@@ -198,7 +266,7 @@ bool trackroute(monster *m, transmatrix goal, double spd) {
   
   // queuepoly(goal, shGrail, 0xFFFFFFC0);
 
-  transmatrix mat = inverse(m->pat) * goal;
+  transmatrix mat = iso_inverse(m->pat) * goal;
   
   transmatrix mat2 = spintox(mat*C0) * mat;
   
@@ -318,7 +386,7 @@ void awakenMimics(monster *m, cell *c2) {
     else
       m2->type = moMimic;
     
-    hyperpoint H = inverse(gmatrix[c2]) * gmatrix[c] * C0;
+    hyperpoint H = iso_inverse(gmatrix[c2]) * gmatrix[c] * C0;
     
     transmatrix xfer = rgpushxto0(H);
 
@@ -327,9 +395,9 @@ void awakenMimics(monster *m, cell *c2) {
       xfer = rspintox(H) * rpushxto0(H2) * mirrortrans * spintox(H);
       }
 
-    m2->pat = gmatrix[c2] * xfer * inverse(gmatrix[c2]) * m->pat;
+    m2->pat = gmatrix[c2] * xfer * iso_inverse(gmatrix[c2]) * m->pat;
       
-    m2->at = inverse(gmatrix[c]) * m2->pat;
+    m2->at = iso_inverse(gmatrix[c]) * m2->pat;
     m2->pid = cpid;
     
     additional.push_back(m2);
@@ -440,7 +508,7 @@ void oceanCurrents(transmatrix& nat, monster *m, int delta) {
 
         // transmatrix t = spintox(H) * xpush(delta/300.) * rspintox(H);
 
-        hyperpoint H = inverse(m->pat) * goal * C0;
+        hyperpoint H = iso_inverse(m->pat) * goal * C0;
         nat = nat * rspintox(H);
         nat = nat * xpush(spd);
         nat = nat * spintox(H);
@@ -464,7 +532,7 @@ bool airCurrents(transmatrix& nat, monster *m, int delta) {
 
       // transmatrix t = spintox(H) * xpush(delta/300.) * rspintox(H);
 
-      hyperpoint H = inverse(m->pat) * goal * C0;
+      hyperpoint H = iso_inverse(m->pat) * goal * C0;
       nat = nat * rspintox(H);
       nat = nat * xpush(spd);
       nat = nat * spintox(H);
@@ -486,7 +554,7 @@ bool airCurrents(transmatrix& nat, monster *m, int delta) {
 
         // transmatrix t = spintox(H) * xpush(delta/300.) * rspintox(H);
 
-        hyperpoint H = inverse(m->pat) * goal * C0;
+        hyperpoint H = iso_inverse(m->pat) * goal * C0;
         nat = nat * rspintox(H);
         nat = nat * xpush(spd);
         nat = nat * spintox(H);
@@ -507,7 +575,7 @@ bool airCurrents(transmatrix& nat, monster *m, int delta) {
 
         // transmatrix t = spintox(H) * xpush(delta/300.) * rspintox(H);
 
-        hyperpoint H = inverse(m->pat) * goal * C0;
+        hyperpoint H = iso_inverse(m->pat) * goal * C0;
         nat = nat * rspintox(H);
         nat = nat * xpush(z * SCALE * delta / 50000.);
         nat = nat * spintox(H);
@@ -542,7 +610,7 @@ void roseCurrents(transmatrix& nat, monster *m, int delta) {
 
       // transmatrix t = spintox(H) * xpush(delta/300.) * rspintox(H);
 
-      hyperpoint H = inverse(m->pat) * goal * C0;
+      hyperpoint H = iso_inverse(m->pat) * goal * C0;
       nat = nat * rspintox(H);
       nat = nat * xpush(spd);
       nat = nat * spintox(H);
@@ -632,7 +700,7 @@ void doTraps() {
         transmatrix& tv = gmatrix.at(tl[4-i]);
         monster* bullet = new monster;
         bullet->base = tl[i];
-        bullet->at = rspintox(inverse(tu) * tC0(tv));
+        bullet->at = rspintox(iso_inverse(tu) * tC0(tv));
         bullet->type = moArrowTrap;
         bullet->parent = &arrowtrap_fakeparent;
         bullet->pid = 0;
@@ -810,7 +878,7 @@ void movePlayer(monster *m, int delta) {
   
       if(sphere && vid.alpha > 1.001) for(int i=0; i<3; i++) ctr[i] = -ctr[i];
   
-      hyperpoint h = inverse(m->pat) * rgpushxto0(ctr) * jh;
+      hyperpoint h = iso_inverse(m->pat) * rgpushxto0(ctr) * jh;
       
       playerturn[cpid] = -atan2(h[1], h[0]);
       mgo += mdd;
@@ -822,7 +890,7 @@ void movePlayer(monster *m, int delta) {
   bool forcetarget = (keystate[SDLK_RSHIFT] | keystate[SDLK_LSHIFT]);
   if(((mousepressed && !forcetarget) || facemouse) && delta > 0 && !mouseout() && !stdracing && GDIM == 2) {
     // playermoved = true;
-    hyperpoint h = inverse(m->pat) * mouseh;
+    hyperpoint h = iso_inverse(m->pat) * mouseh;
     playerturn[cpid] = -atan2(h[1], h[0]);
     // nat = nat * spin(alpha);
     // mturn += alpha * 150. / delta;
@@ -962,7 +1030,7 @@ void movePlayer(monster *m, int delta) {
       hyperpoint drag = m->inertia * cinertia * delta / -1. / SCALE;
       m->inertia += drag;
       avg_inertia += drag/2;
-      transmatrix T = inverse(m->pat);
+      transmatrix T = iso_inverse(m->pat);
       ld xp = SCALE / 60000. / isize(below) * delta / 15;
       ld yp = 0;
       if(cwt.at->land == laDungeon) xp = -xp;
@@ -1335,12 +1403,12 @@ void virtualize(monster *m) {
 
 bool reflectmatrix(transmatrix& M, cell *c1, cell *c2, bool onlypos) {
   if(!gmatrix.count(c1) || !gmatrix.count(c2)) return false;
-  transmatrix H = inverse(gmatrix[c1]) * gmatrix[c2];
+  transmatrix H = iso_inverse(gmatrix[c1]) * gmatrix[c2];
   transmatrix S = spintox(tC0(H));
   ld d = hdist0(tC0(H));
-  transmatrix T = xpush(-d/2) * S * inverse(gmatrix[c1]) * M;
+  transmatrix T = xpush(-d/2) * S * iso_inverse(gmatrix[c1]) * M;
   if(onlypos && tC0(T)[0] < 0) return false;
-  M = gmatrix[c1] * inverse(S) * xpush(d/2) * MirrorX * T;
+  M = gmatrix[c1] * iso_inverse(S) * xpush(d/2) * MirrorX * T;
   return true;
   }
 
@@ -1450,7 +1518,7 @@ void destroyMimics() {
 EX void teleported() {
   monster *m = pc[cpid];
   m->base = cwt.at;
-  m->at = rgpushxto0(inverse(gmatrix[cwt.at]) * mouseh) * spin(rand() % 1000 * M_PI / 2000);
+  m->at = rgpushxto0(iso_inverse(gmatrix[cwt.at]) * mouseh) * spin(rand() % 1000 * M_PI / 2000);
   m->findpat();
   destroyMimics();
   }
@@ -1458,7 +1526,7 @@ EX void teleported() {
 void shoot(eItem it, monster *m) {
   monster* bullet = new monster;
   bullet->base = m->base;
-  bullet->at = m->at * rspintox(inverse(m->pat) * mouseh);
+  bullet->at = m->at * rspintox(iso_inverse(m->pat) * mouseh);
   /* ori */
   if(WDIM == 3) bullet->at = bullet->at * cpush(2, 0.15 * SCALE);
   bullet->type = it == itOrbDragon ? moFireball : it == itOrbAir ? moAirball : moBullet;
@@ -1563,7 +1631,7 @@ void spawn_asteroids(monster *bullet, monster *target) {
   if(target->hitpoints <= 1) return;
   hyperpoint rnd = random_spin() * point2(SCALE/3000., 0);
   
-  hyperpoint bullet_inertia = inverse(target->pat) * bullet->pat * bullet->inertia;
+  hyperpoint bullet_inertia = iso_inverse(target->pat) * bullet->pat * bullet->inertia;
 
   for(int i=0; i<2; i++) {
     monster* child = new monster;
@@ -1697,7 +1765,7 @@ void moveBullet(monster *m, int delta) {
       if(m->type == moAirball && isBlowableMonster(m2->type)) {
 
         if(m2->blowoff < curtime) {
-          hyperpoint h = inverse(m2->pat) * nat0 * C0;
+          hyperpoint h = iso_inverse(m2->pat) * nat0 * C0;
           if(WDIM == 3)
            swordmatrix[m2->pid] = spintox(h) * swordmatrix[m2->pid];
           else
@@ -1709,7 +1777,7 @@ void moveBullet(monster *m, int delta) {
         }
       // Hedgehog Warriors only killable outside of the 45 degree angle
       if(m2->type == moHedge && !peace::on && !slayer) {
-        hyperpoint h = inverse(m2->pat) * m->pat * C0;
+        hyperpoint h = iso_inverse(m2->pat) * m->pat * C0;
         if(h[0] > fabsl(h[1])) { m->dead = true; continue; }
         }
       if(peace::on && !isIvy(m2->type)) {
@@ -1808,7 +1876,7 @@ EX bool dragonbreath(cell *dragon) {
   int randplayer = hrand(numplayers());
   monster* bullet = new monster;
   bullet->base = dragon;
-  bullet->at = spin_towards(Id, bullet->ori, inverse(gmatrix[dragon]) * tC0(pc[randplayer]->pat), bulletdir(), 1);
+  bullet->at = spin_towards(Id, bullet->ori, iso_inverse(gmatrix[dragon]) * tC0(pc[randplayer]->pat), bulletdir(), 1);
   bullet->type = moFireball;
   bullet->parent = bullet;
   bullet->pid = randplayer;
@@ -2032,7 +2100,7 @@ void moveMonster(monster *m, int delta) {
       }
 
     if(m->type == moHedge) {
-      hyperpoint h = inverse(m->pat) * goal * C0;
+      hyperpoint h = iso_inverse(m->pat) * goal * C0;
       if(h[1] < 0)
         nat = nat * spin(M_PI * delta / 3000 / speedfactor());
       else
@@ -2398,15 +2466,7 @@ void moveMonster(monster *m, int delta) {
   }
 
 void activateMonstersAt(cell *c) {
-  pair<mit, mit> p = 
-    monstersAt.equal_range(c);
-  for(mit it = p.first; it != p.second;) {
-    mit itplus = it;
-    itplus++;
-    active.push_back(it->second);
-    monstersAt.erase(it);
-    it = itplus;
-    }
+  monstersAt.take(c, active);
   if(c->monst && isMimic(c->monst)) c->monst = moNone;
   // mimics are awakened by awakenMimics
   if(c->monst && !isIvy(c) && !isWorm(c) && !isMutantIvy(c) && !isKraken(c->monst) && c->monst != moPrincess && c->monst != moHunterGuard) {
@@ -2431,14 +2491,11 @@ void activateMonstersAt(cell *c) {
 
 EX void fixStorage() {
 
-  vector<monster*> restore;
-
-  for(auto it = monstersAt.begin(); it != monstersAt.end(); it++) 
-    restore.push_back(it->second);
+  vector<monster*> restore = monstersAt.all();
 
   monstersAt.clear();
 
-  for(monster *m: restore) m->store();
+  for(monster *m: restore) m->prev_stored = NULL, m->store();
   }
 
 EX hookset<bool(int)> *hooks_turn;
@@ -2495,7 +2552,7 @@ EX void turn(int delta) {
   if(doall)
     for(cell *c: currentmap->allcells()) activateMonstersAt(c);
   else
-    for(unordered_map<cell*, transmatrix>::iterator it = gmatrix.begin(); it != gmatrix.end(); it++) 
+    for(auto it = gmatrix.begin(); it != gmatrix.end(); it++) 
       activateMonstersAt(it->first);
   
   /* printf("size: gmatrix = %ld, active = %ld, monstersAt = %ld, delta = %d\n", 
@@ -2535,8 +2592,17 @@ EX void turn(int delta) {
       moveMimic(m);
     }
 
+  // groups of the same passability class share the path data
+  
+  bool done[motypes];
+  for(int i=0; i<motypes; i++) done[i] = false;
+
   for(int t=1; t<motypes; t++) if(exists[t]) {
   
+    eMonster cls = passability_class(eMonster(t));
+    if(done[cls]) continue;
+    done[cls] = true;
+  
     pathdata pd(1);
         
     // build the path data
@@ -2553,7 +2619,7 @@ EX void turn(int delta) {
         cell *c2 = c->move(i);
         // printf("i=%d cd=%d\n", i, c->move(i)->cpdist);
         if(c2 && c2->pathdist == PINFD && gmatrix.count(c2) && 
-          (passable_for(eMonster(t), c, c2, P_CHAIN | P_ONPLAYER) || c->wall == waThumperOn)) {
+          (passable_for(cls, c, c2, P_CHAIN | P_ONPLAYER) || c->wall == waThumperOn)) {
           onpath(c2, d+1);
           }
         }
@@ -2561,11 +2627,12 @@ EX void turn(int delta) {
     
     // printf("time %d, t=%d, q=%d\n", curtime, t, qb);
   
-    // move monsters of this type
+    // move monsters of this class
     
-    for(monster *m: nonvirtual)
-      if(movegroup(m->type) == t)
-        moveMonster(m, delta);
+    for(int t1=t; t1<motypes; t1++) if(exists[t1] && passability_class(eMonster(t1)) == cls)
+      for(monster *m: nonvirtual)
+        if(movegroup(m->type) == t1)
+          moveMonster(m, delta);
     }
   
   if(shmup::on) {
@@ -2744,20 +2811,16 @@ EX void init() {
   }
 
 EX bool boatAt(cell *c) {
-  pair<mit, mit> p = 
-    monstersAt.equal_range(c);
-  for(mit it = p.first; it != p.second; it++) {
-    monster* m = it->second;
+  for(monster *m = monstersAt.at(c); m; m = m->next_stored)
     if(m->inBoat) return true;
-    }
   return false;
   }
 
 EX hookset<bool(const transmatrix&, cell*, shmup::monster*)> *hooks_draw;
 
 EX void clearMonsters() {
-  for(mit it = monstersAt.begin(); it != monstersAt.end(); it++)
-    delete(it->second);
+  for(monster *m: monstersAt.all())
+    delete m;
   for(monster *m: active) delete m;
   mousetarget = NULL;
   lmousetarget = NULL;
@@ -2829,14 +2892,10 @@ EX void addShmupHelp(string& out) {
 auto hooks = addHook(clearmemory, 0, shmup::clearMemory) +
   addHook(hooks_gamedata, 0, shmup::gamedata) +
   addHook(hooks_removecells, 0, [] () {
-    for(mit it = monstersAt.begin(); it != monstersAt.end();) {
-      if(is_cell_removed(it->first)) {
-        monstersAt.insert(make_pair(nullptr, it->second));
-        auto it0 = it; it++;
-        monstersAt.erase(it0);
-        }
-      else it++;
-      }
+    vector<monster*> restore = monstersAt.all();
+    monstersAt.clear();
+    for(monster *m: restore) 
+      monstersAt.insert(is_cell_removed(m->stored_at) ? nullptr : m->stored_at, m);
     });
 
 EX void switch_shmup() { 
@@ -2849,7 +2908,7 @@ EX void switch_shmup() {
 
 #if MAXMDIM >= 4
 auto hooksw = addHook(hooks_swapdim, 100, [] {
-  for(auto& p: monstersAt) swapmatrix(p.second->at);
+  for(monster *m: monstersAt.all()) swapmatrix(m->at);
   });
 #endif
     
@@ -2860,16 +2919,12 @@ bool celldrawer::draw_shmup_monster() {
   auto& c = cw.at;
   #if CAP_SHAPES
 
-  pair<mit, mit> p = 
-    monstersAt.equal_range(c);
+  monster *first = monstersAt.at(c);
     
-  if(p.first == p.second) return false;
+  if(!first) return false;
   ld zlev = -geom3::factor_to_lev(zlevel(tC0(Vd)));
    
-  vector<monster*> monsters;
-
-  for(mit it = p.first; it != p.second; it++) {
-    monster* m = it->second;
+  for(monster *m = first; m; m = m->next_stored) {
     if(c != m->base) continue; // may happen in RogueViz Collatz
     m->pat = ggmatrix(m->base) * m->at;
     transmatrix view = V * m->at;
@@ -0,0 +1,348 @@
+// Hyperbolic Rogue -- software rasterizer
+// Copyright (C) 2011-2019 Zeno Rogue, see 'hyper.cpp' for details
+
+/** \file softraster.cpp
+ *  \brief a tile-based software rasterizer for the non-OpenGL mode
+ *
+ *  When enabled, the primitives which would be drawn with SDL_gfx (filled polygons,
+ *  textured triangles and polylines) are recorded instead, binned into screen tiles,
+ *  and the tiles are then rasterized in parallel (see draw_threads). Within a tile
+ *  the primitives are drawn in the order they were recorded, so the result does not
+ *  depend on the number of threads. Anything else drawn on the surface (texts, circles)
+ *  flushes the recorded primitives first.
+ */
+
+#include "hyper.h"
+namespace hr {
+
+#if CAP_SDL
+EX namespace softraster {
+
+/** use the software rasterizer instead of SDL_gfx in the non-OpenGL mode */
+EX bool on = false;
+
+/** are the primitives currently recorded, instead of being drawn immediately */
+EX bool collecting = false;
+
+static const int TILE_SHIFT = 6;
+static const int TILE = 1 << TILE_SHIFT;
+
+enum ePrimitive { prFill, prTexture, prLine, prAALine };
+
+/** a recorded primitive; for fills the edges are in edges[first..first+qty), otherwise the vertices are in vx/vy[first..first+qty) */
+struct primitive {
+  ePrimitive kind;
+  color_t col;
+  int first, qty;
+  int minx, miny, maxx, maxy;
+  const color_t *tpix;
+  int tw;
+  };
+
+/** a non-horizontal polygon edge, covering the pixel rows y0..y1-1; x is its position at the center of row y0 */
+struct edge {
+  int y0, y1;
+  double x, dxdy;
+  };
+
+struct active_edge {
+  double x, dxdy;
+  int y0, y1;
+  };
+
+/** per-thread buffers */
+struct worker {
+  vector<active_edge> active;
+  vector<double> crossings;
+  };
+
+vector<primitive> prims;
+vector<edge> edges;
+vector<int> vx, vy;
+vector<glvertex> tvs;
+
+SDL_Surface *target;
+int tiles_x, tiles_y;
+vector<vector<int>> tiles;
+
+/** blend col (in the 0xRRGGBBAA format) onto n pixels; the red/blue and green lanes are blended in a single multiplication each */
+static void blend_span(color_t *p, int n, color_t col) {
+  color_t alpha = col & 0xFF;
+  color_t rgb = col >> 8;
+  if(alpha == 255) {
+    for(int i=0; i<n; i++) p[i] = (p[i] & 0xFF000000) | rgb;
+    return;
+    }
+  color_t a = alpha + (alpha >> 7), inv = 256 - a;
+  color_t srb = (rgb & 0xFF00FF) * a, sg = (rgb & 0xFF00) * a;
+  for(int i=0; i<n; i++) {
+    color_t d = p[i];
+    color_t rb = (((d & 0xFF00FF) * inv + srb) >> 8) & 0xFF00FF;
+    color_t g = (((d & 0xFF00) * inv + sg) >> 8) & 0xFF00;
+    p[i] = (d & 0xFF000000) | rb | g;
+    }
+  }
+
+static void blend_pixel(color_t& p, color_t col, int alpha) {
+  if(alpha > 0) blend_span(&p, 1, (col & 0xFFFFFF00) | alpha);
+  }
+
+static color_t *row(int y) {
+  return (color_t*) ((char*) target->pixels + y * target->pitch);
+  }
+
+struct cliprect { int x0, y0, x1, y1; };
+
+/** even-odd scanline fill: a pixel is filled when its center is inside */
+static void draw_fill(const primitive& pr, const cliprect& r, worker& w) {
+  int y0 = max(pr.miny, r.y0), y1 = min(pr.maxy + 1, r.y1);
+  if(y0 >= y1) return;
+  auto& act = w.active;
+  act.clear();
+  for(int i=pr.first; i<pr.first+pr.qty; i++) {
+    auto& e = edges[i];
+    if(e.y1 <= y0 || e.y0 >= y1) continue;
+    int ys = max(e.y0, y0);
+    act.push_back(active_edge{e.x + (ys - e.y0) * e.dxdy, e.dxdy, ys, e.y1});
+    }
+  auto& cr = w.crossings;
+  for(int y=y0; y<y1; y++) {
+    cr.clear();
+    for(auto& a: act) if(y >= a.y0 && y < a.y1) {
+      cr.push_back(a.x);
+      a.x += a.dxdy;
+      }
+    for(int i=1; i<isize(cr); i++)
+      for(int j=i; j && cr[j] < cr[j-1]; j--) swap(cr[j], cr[j-1]);
+    color_t *line = row(y);
+    for(int i=0; i+1<isize(cr); i+=2) {
+      int xa = max<double>(ceil(cr[i] - .5), r.x0);
+      int xb = min<double>(ceil(cr[i+1] - .5), r.x1);
+      if(xa < xb) blend_span(line + xa, xb - xa, pr.col);
+      }
+    }
+  }
+
+#if CAP_TEXTURE
+/** textured triangle, using edge functions stepped incrementally; the coordinates are doubled, so the pixel centers are at odd integers */
+static void draw_texture(const primitive& pr, const cliprect& r) {
+  int x0 = max(pr.minx, r.x0), x1 = min(pr.maxx + 1, r.x1);
+  int y0 = max(pr.miny, r.y0), y1 = min(pr.maxy + 1, r.y1);
+  if(x0 >= x1 || y0 >= y1) return;
+  long long X[3], Y[3];
+  glvertex T[3];
+  for(int i=0; i<3; i++) X[i] = 2 * vx[pr.first+i], Y[i] = 2 * vy[pr.first+i], T[i] = tvs[pr.first+i];
+  long long A[3], B[3], C[3];
+  for(int i=0; i<3; i++) {
+    int j = (i+1) % 3, k = (i+2) % 3;
+    A[i] = Y[j] - Y[k];
+    B[i] = X[k] - X[j];
+    C[i] = X[j] * Y[k] - X[k] * Y[j];
+    }
+  long long area = A[0] * X[0] + B[0] * Y[0] + C[0];
+  if(area == 0) return;
+  if(area < 0) for(int i=0; i<3; i++) A[i] = -A[i], B[i] = -B[i], C[i] = -C[i];
+  double ia = 1. / abs(area);
+  /* ties are broken so that the pixels on an edge shared by two triangles are drawn once */
+  long long bias[3];
+  for(int i=0; i<3; i++) bias[i] = (A[i] > 0 || (A[i] == 0 && B[i] > 0)) ? 0 : -1;
+  double du_dx = 0, dv_dx = 0;
+  for(int i=0; i<3; i++) du_dx += 2 * A[i] * ia * T[i][0], dv_dx += 2 * A[i] * ia * T[i][1];
+  int tw = pr.tw;
+  const color_t *tpix = pr.tpix;
+  color_t col = pr.col;
+  int ca = part(col, 0);
+  for(int y=y0; y<y1; y++) {
+    long long E[3];
+    double u = 0, v = 0;
+    for(int i=0; i<3; i++) {
+      E[i] = A[i] * (2*x0+1) + B[i] * (2*y+1) + C[i];
+      u += E[i] * ia * T[i][0], v += E[i] * ia * T[i][1];
+      }
+    color_t *line = row(y);
+    for(int x=x0; x<x1; x++) {
+      if((E[0] + bias[0]) >= 0 && (E[1] + bias[1]) >= 0 && (E[2] + bias[2]) >= 0) {
+        color_t c = tpix[(int(v * tw) & (tw-1)) * tw + (int(u * tw) & (tw-1))];
+        unsigned alpha = part(c, 3) * ca;
+        color_t& pix = line[x];
+        for(int p=0; p<3; p++) {
+          auto& val = part(pix, p);
+          val = ((255*255 - alpha) * 255 * val + alpha * part(col, p+1) * part(c, p) + 255 * 255 * 255/2 + 1) / (255 * 255 * 255);
+          }
+        }
+      for(int i=0; i<3; i++) E[i] += 2 * A[i];
+      u += du_dx, v += dv_dx;
+      }
+    }
+  }
+#endif
+
+/** a line segment, stepped along its major axis; antialiased lines split each step between the two nearest pixels */
+static void draw_line(const primitive& pr, const cliprect& r) {
+  int ax = vx[pr.first], ay = vy[pr.first], bx = vx[pr.first+1], by = vy[pr.first+1];
+  bool aa = pr.kind == prAALine;
+  int alpha = pr.col & 0xFF;
+  bool steep = abs(by - ay) > abs(bx - ax);
+  if(steep) swap(ax, ay), swap(bx, by);
+  if(ax > bx) swap(ax, bx), swap(ay, by);
+  /* (major, minor) ranges of the clip rectangle */
+  int mj0 = steep ? r.y0 : r.x0, mj1 = steep ? r.y1 : r.x1;
+  int mn0 = steep ? r.x0 : r.y0, mn1 = steep ? r.x1 : r.y1;
+  double slope = ax == bx ? 0 : (by - ay) * 1. / (bx - ax);
+  int m0 = max(ax, mj0), m1 = min(bx + 1, mj1);
+  if(m0 >= m1) return;
+  double f = ay + (m0 - ax) * slope;
+  auto plot = [&] (int mj, int mn, int a) {
+    if(mn < mn0 || mn >= mn1) return;
+    if(steep) blend_pixel(row(mj)[mn], pr.col, a);
+    else blend_pixel(row(mn)[mj], pr.col, a);
+    };
+  for(int m=m0; m<m1; m++, f += slope) {
+    if(aa) {
+      int i = floor(f);
+      int fr = int((f - i) * 256);
+      plot(m, i, (alpha * (256 - fr)) >> 8);
+      plot(m, i+1, (alpha * fr) >> 8);
+      }
+    else plot(m, floor(f + .5), alpha);
+    }
+  }
+
+static void draw_tile(int t, worker& w) {
+  int tx = t % tiles_x, ty = t / tiles_x;
+  cliprect r{tx << TILE_SHIFT, ty << TILE_SHIFT, min((tx+1) << TILE_SHIFT, target->w), min((ty+1) << TILE_SHIFT, target->h)};
+  for(int id: tiles[t]) {
+    auto& pr = prims[id];
+    switch(pr.kind) {
+      case prFill: draw_fill(pr, r, w); break;
+      #if CAP_TEXTURE
+      case prTexture: draw_texture(pr, r); break;
+      #endif
+      case prLine: case prAALine: draw_line(pr, r); break;
+      default: break;
+      }
+    }
+  }
+
+/** draw all the recorded primitives */
+EX void flush() {
+  if(prims.empty()) return;
+  vector<int> todo;
+  for(int t=0; t<isize(tiles); t++) if(!tiles[t].empty()) todo.push_back(t);
+  SDL_LockSurface(target);
+  #if CAP_THREAD
+  // small flushes (e.g., before a text or a circle) are not worth waking the workers
+  int threads = isize(prims) >= 256 ? min(draw_threads, isize(todo)) : 1;
+  if(threads > 1) {
+    draw_pool.run(threads, [&todo, threads] (int k) {
+      worker w;
+      for(int i=k; i<isize(todo); i+=threads) draw_tile(todo[i], w);
+      });
+    }
+  else
+  #endif
+  {
+    worker w;
+    for(int t: todo) draw_tile(t, w);
+    }
+  SDL_UnlockSurface(target);
+  for(int t: todo) tiles[t].clear();
+  prims.clear(); edges.clear(); vx.clear(); vy.clear(); tvs.clear();
+  }
+
+static void set_target(SDL_Surface *srf) {
+  if(srf == target && tiles_x == (srf->w + TILE - 1) >> TILE_SHIFT && tiles_y == (srf->h + TILE - 1) >> TILE_SHIFT) return;
+  flush();
+  target = srf;
+  tiles_x = (srf->w + TILE - 1) >> TILE_SHIFT;
+  tiles_y = (srf->h + TILE - 1) >> TILE_SHIFT;
+  tiles.clear();
+  tiles.resize(tiles_x * tiles_y);
+  }
+
+/** clip the bounding box of pr to the target, and add it to the tiles it overlaps */
+static void bin(primitive& pr) {
+  pr.minx = max(pr.minx, 0); pr.miny = max(pr.miny, 0);
+  pr.maxx = min(pr.maxx, target->w - 1); pr.maxy = min(pr.maxy, target->h - 1);
+  if(pr.minx > pr.maxx || pr.miny > pr.maxy) return;
+  int id = isize(prims);
+  prims.push_back(pr);
+  for(int ty = pr.miny >> TILE_SHIFT; ty <= pr.maxy >> TILE_SHIFT; ty++)
+  for(int tx = pr.minx >> TILE_SHIFT; tx <= pr.maxx >> TILE_SHIFT; tx++)
+    tiles[ty * tiles_x + tx].push_back(id);
+  }
+
+/** start recording, if the software rasterizer should be used for drawing on s */
+EX void begin() {
+  collecting = on && !vid.usingGL && s && s->pixels && !current_display->stereo_active();
+  #if CAP_SVG
+  if(svg::in) collecting = false;
+  #endif
+  if(collecting) set_target(s);
+  }
+
+EX void end() {
+  if(!collecting) return;
+  flush();
+  collecting = false;
+  }
+
+/** record a polygon filled using the even-odd rule, like SDL_gfx's filledPolygonColor */
+EX void add_fill(SDL_Surface *srf, int *px, int *py, int n, color_t col) {
+  set_target(srf);
+  if(n < 3 || !(col & 0xFF)) return;
+  primitive pr;
+  pr.kind = prFill; pr.col = col; pr.first = isize(edges);
+  pr.minx = pr.maxx = px[0]; pr.miny = pr.maxy = py[0];
+  for(int i=0; i<n; i++) {
+    int j = (i+1) % n;
+    pr.minx = min(pr.minx, px[i]); pr.maxx = max(pr.maxx, px[i]);
+    pr.miny = min(pr.miny, py[i]); pr.maxy = max(pr.maxy, py[i]);
+    if(py[i] == py[j]) continue;
+    int a = py[i] < py[j] ? i : j, b = i+j-a;
+    edge e;
+    e.y0 = py[a]; e.y1 = py[b];
+    e.dxdy = (px[b] - px[a]) * 1. / (py[b] - py[a]);
+    e.x = px[a] + e.dxdy / 2;
+    edges.push_back(e);
+    }
+  pr.qty = isize(edges) - pr.first;
+  bin(pr);
+  }
+
+#if CAP_TEXTURE
+EX void add_textured_triangle(SDL_Surface *srf, int *px, int *py, glvertex *tv, color_t col) {
+  set_target(srf);
+  primitive pr;
+  pr.kind = prTexture; pr.col = col; pr.first = isize(vx); pr.qty = 3;
+  pr.tpix = &texture::config.data.texture_pixels[0];
+  pr.tw = texture::config.data.twidth;
+  pr.minx = pr.maxx = px[0]; pr.miny = pr.maxy = py[0];
+  for(int i=0; i<3; i++) {
+    vx.push_back(px[i]); vy.push_back(py[i]); tvs.push_back(tv[i]);
+    pr.minx = min(pr.minx, px[i]); pr.maxx = max(pr.maxx, px[i]);
+    pr.miny = min(pr.miny, py[i]); pr.maxy = max(pr.maxy, py[i]);
+    }
+  bin(pr);
+  }
+#endif
+
+/** record a polyline, like SDL_gfx's lineColor or aalineColor applied to consecutive vertices */
+EX void add_polyline(SDL_Surface *srf, int *px, int *py, int n, color_t col, bool aa) {
+  set_target(srf);
+  if(!(col & 0xFF)) return;
+  for(int i=1; i<n; i++) {
+    primitive pr;
+    pr.kind = aa ? prAALine : prLine; pr.col = col; pr.first = isize(vx); pr.qty = 2;
+    vx.push_back(px[i-1]); vy.push_back(py[i-1]);
+    vx.push_back(px[i]); vy.push_back(py[i]);
+    pr.minx = min(px[i-1], px[i]) - 1; pr.maxx = max(px[i-1], px[i]) + 1;
+    pr.miny = min(py[i-1], py[i]) - 1; pr.maxy = max(py[i-1], py[i]) + 1;
+    bin(pr);
+    }
+  }
+
+EX }
+#endif
+
+}
@@ -148,6 +148,7 @@ struct hrmap_spherical : hrmap_standard {
 
   ~hrmap_spherical() {
     dynamicval<eVariation> ph(variation, mvar);
+    if(bulk_release()) return;
     for(int i=0; i<spherecells(); i++) clearHexes(dodecahedron[i]);
     for(int i=0; i<spherecells(); i++) tailored_delete(dodecahedron[i]);
     }    
@@ -149,6 +149,10 @@
 #define CAP_SURFACE CAP_RUG
 #endif
 
+#ifndef CAP_THREAD
+#define CAP_THREAD (!ISMOBWEB && !ISMINI && !ISWINDOWS)
+#endif
+
 #ifndef CAP_EDIT
 #define CAP_EDIT (CAP_FILES && !ISWEB && !ISMINI)
 #endif
@@ -412,6 +416,8 @@ extern "C" {
 #include <string>
 #include <map>
 #include <queue>
+#include <deque>
+#include <list>
 #include <stdexcept>
 #include <array>
 #include <set>
@@ -427,8 +433,15 @@ extern "C" {
 
 #include <stdint.h>
 
+#if CAP_THREAD
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
 #if ISWINDOWS
 #include "direntx.h"
+#include <malloc.h>
 #else
 #include <dirent.h>
 #endif
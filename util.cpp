@@ -140,6 +140,41 @@ struct exp_parser {
     }
 
   };
+
+/** opcodes of exp_program */
+enum eExpOp {
+  eoPush, eoLoad, eoStore, eoParam, eoNeg, eoAdd, eoSub, eoMul, eoDiv, eoPow,
+  eoSin, eoCos, eoSinh, eoCosh, eoAsin, eoAcos, eoAsinh, eoAcosh, eoExp, eoLog, eoTan, eoTanh, eoAtan, eoAtanh,
+  eoAbs, eoRe, eoIm, eoConj, eoFloor, eoFrac, eoTo01, eoIfp, eoRgb, eoAnim,
+  eoSeconds, eoMilliseconds, eoMouseX, eoMouseY, eoMouseZ, eoShot
+  };
+
+struct exp_instruction {
+  eExpOp op;
+  int arg;
+  cld val;
+  ld *param;
+  };
+
+/** an expression in the exp_parser language, compiled to a stack bytecode; the variables named at compile time are referred to by slot index */
+struct exp_program {
+  /** the source this program has been compiled from */
+  string source;
+  /** the variables, in the order of the values given to evaluate */
+  vector<string> names;
+  /** false if compilation failed -- evaluate then falls back to exp_parser, so that the results are always the same */
+  bool valid;
+  bool compiled;
+  vector<exp_instruction> code;
+  int nslots;
+  vector<cld> slots, stack;
+  
+  exp_program() { valid = compiled = false; nslots = 0; }
+  void compile(const string& s, const vector<string>& n);
+  /** recompile only if the source or the variable names have changed */
+  void compile_if_needed(const string& s, const vector<string>& n) { if(!compiled || s != source || n != names) compile(s, n); }
+  cld evaluate(const cld *values);
+  };
 #endif
 
 cld exp_parser::parse(int prio) {
@@ -255,6 +290,238 @@ cld exp_parser::parse(int prio) {
   return res;
   }
 
+/** compiles an expression for exp_program; mirrors exp_parser::parse, but emits instructions instead of computing the values */
+struct exp_compiler : exp_parser {
+  exp_program& prog;
+  map<string, int> scope;
+  
+  exp_compiler(exp_program& p) : prog(p) {}
+  
+  void emit(eExpOp op, int arg = 0, cld val = 0, ld *param = nullptr) {
+    exp_instruction i;
+    i.op = op; i.arg = arg; i.val = val; i.param = param;
+    prog.code.push_back(i);
+    }
+  
+  int new_slot() { return prog.nslots++; }
+  
+  void compile(int prio = 0);
+  
+  void compilepar() {
+    compile();
+    if(next() != ')') { at = -1; return; }
+    at++;
+    }
+  
+  bool comma() {
+    if(next() != ',') { at = -1; return false; }
+    at++;
+    return true;
+    }
+  };
+
+void exp_compiler::compile(int prio) {
+  while(next() == ' ') at++;
+  static const vector<pair<const char*, eExpOp>> functions = {
+    {"sin(", eoSin}, {"cos(", eoCos}, {"sinh(", eoSinh}, {"cosh(", eoCosh}, {"asin(", eoAsin}, {"acos(", eoAcos},
+    {"asinh(", eoAsinh}, {"acosh(", eoAcosh}, {"exp(", eoExp}, {"log(", eoLog}, {"tan(", eoTan}, {"tanh(", eoTanh},
+    {"atan(", eoAtan}, {"atanh(", eoAtanh}, {"abs(", eoAbs}, {"re(", eoRe}, {"im(", eoIm}, {"conj(", eoConj},
+    {"floor(", eoFloor}, {"frac(", eoFrac}
+    };
+  bool found = false;
+  for(auto& f: functions) if(eat(f.first)) { compilepar(); emit(f.second); found = true; break; }
+  if(found) ;
+  else if(eat("to01(")) { compilepar(); emit(eoTo01); return; }
+  else if(eat("ifp(")) {
+    compile(0);
+    if(!comma()) return;
+    compile(0);
+    if(!comma()) return;
+    compilepar();
+    emit(eoIfp);
+    return;
+    }
+  else if(eat("rgb(")) {
+    compile(0);
+    if(!comma()) return;
+    compile(0);
+    if(!comma()) return;
+    compilepar();
+    emit(eoRgb, scope.count("p") ? scope["p"] : -1);
+    return;
+    }
+  else if(eat("let(")) {
+    string name;
+    while(true) {
+      char c = next();
+      if((c >= '0' && c <= '9') || (c == '.' && next(1) != '.') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+        name += c, at++;
+      else break;
+      }
+    if(next() != '=') { at = -1; return; }
+    at++;
+    compile(0);
+    if(!comma()) return;
+    int slot = new_slot();
+    emit(eoStore, slot);
+    /* exp_parser keeps the name defined (as 0) after the let */
+    int outer = scope.count(name) ? scope[name] : new_slot();
+    scope[name] = slot;
+    compilepar();
+    scope[name] = outer;
+    return;
+    }
+  else if(next() == '(') at++, compilepar();
+  else {
+    string number;
+    while(true) {
+      char c = next();
+      if((c >= '0' && c <= '9') || (c == '.' && next(1) != '.') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+        number += c, at++;
+      else break;
+      }
+    if(number == "e") emit(eoPush, 0, exp(1));
+    else if(number == "i") emit(eoPush, 0, cld(0, 1));
+    else if(number == "p" || number == "pi") emit(eoPush, 0, M_PI);
+    else if(number == "" && next() == '-') { at++; compile(prio); emit(eoNeg); }
+    else if(number == "") at = -1;
+    else if(number == "s") emit(eoSeconds);
+    else if(number == "ms") emit(eoMilliseconds);
+    else if(number[0] == '0' && number[1] == 'x') emit(eoPush, 0, strtoll(number.c_str()+2, NULL, 16));
+    else if(number == "mousex") emit(eoMouseX);
+    else if(number == "mousey") emit(eoMouseY);
+    else if(number == "mousez") emit(eoMouseZ);
+    else if(number == "shot") emit(eoShot);
+    else if(scope.count(number)) emit(eoLoad, scope[number]);
+    else if(params.count(number)) emit(eoParam, 0, 0, &params.at(number));
+    else if(number[0] >= 'a' && number[0] <= 'z') at = -1;
+    else { std::stringstream ss; cld res = 0; ss << number; ss >> res; emit(eoPush, 0, res); }
+    }
+  while(true) {
+    #if CAP_ANIMATIONS
+    if(next() == '.' && next(1) == '.' && prio == 0) {
+      int qty = 1;
+      while(next() == '.' && next(1) == '.') {
+        at += 2; compile(10); qty++;
+        }
+      emit(eoAnim, qty);
+      return;
+      }
+    else 
+    #endif
+    if(next() == '+' && prio <= 10) at++, compile(20), emit(eoAdd);
+    else if(next() == '-' && prio <= 10) at++, compile(20), emit(eoSub);
+    else if(next() == '*' && prio <= 20) at++, compile(30), emit(eoMul);
+    else if(next() == '/' && prio <= 20) at++, compile(30), emit(eoDiv);
+    else if(next() == '^') at++, compile(40), emit(eoPow);
+    else break;
+    }
+  }
+
+void exp_program::compile(const string& s, const vector<string>& n) {
+  source = s; names = n;
+  compiled = true;
+  code.clear();
+  nslots = 0;
+  exp_compiler ec(*this);
+  ec.s = s;
+  for(auto& name: n) ec.scope[name] = nslots++;
+  ec.compile();
+  valid = ec.at != -1;
+  if(!valid) code.clear();
+  }
+
+cld exp_program::evaluate(const cld *values) {
+  if(!valid) {
+    exp_parser ep;
+    for(int i=0; i<isize(names); i++) ep.extra_params[names[i]] = values[i];
+    ep.s = source;
+    return ep.parse();
+    }
+  slots.resize(nslots);
+  for(int i=0; i<isize(names); i++) slots[i] = values[i];
+  for(int i=isize(names); i<nslots; i++) slots[i] = 0;
+  /* the bottom element is a sentinel, so that top is always valid */
+  stack.resize(1);
+  for(auto& in: code) {
+    cld& top = stack.back();
+    switch(in.op) {
+      case eoPush: stack.push_back(in.val); break;
+      case eoLoad: stack.push_back(slots[in.arg]); break;
+      case eoStore: slots[in.arg] = top; stack.pop_back(); break;
+      case eoParam: stack.push_back(*in.param); break;
+      case eoNeg: top = -top; break;
+      case eoAdd: case eoSub: case eoMul: case eoDiv: case eoPow: {
+        cld b = top; stack.pop_back();
+        cld& a = stack.back();
+        switch(in.op) {
+          case eoAdd: a = a + b; break;
+          case eoSub: a = a - b; break;
+          case eoMul: a = a * b; break;
+          case eoDiv: a = a / b; break;
+          default: a = pow(a, b); break;
+          }
+        break;
+        }
+      case eoSin: top = sin(top); break;
+      case eoCos: top = cos(top); break;
+      case eoSinh: top = sinh(top); break;
+      case eoCosh: top = cosh(top); break;
+      case eoAsin: top = asin(top); break;
+      case eoAcos: top = acos(top); break;
+      case eoAsinh: top = asinh(top); break;
+      case eoAcosh: top = acosh(top); break;
+      case eoExp: top = exp(top); break;
+      case eoLog: top = log(top); break;
+      case eoTan: top = tan(top); break;
+      case eoTanh: top = tanh(top); break;
+      case eoAtan: top = atan(top); break;
+      case eoAtanh: top = atanh(top); break;
+      case eoAbs: top = abs(top); break;
+      case eoRe: top = real(top); break;
+      case eoIm: top = imag(top); break;
+      case eoConj: top = std::conj(top); break;
+      case eoFloor: top = floor(real(top)); break;
+      case eoFrac: top = top - floor(real(top)); break;
+      case eoTo01: top = atan(top) / ld(M_PI) + ld(0.5); break;
+      case eoIfp: case eoRgb: {
+        cld val2 = top; stack.pop_back();
+        cld val1 = stack.back(); stack.pop_back();
+        cld& val0 = stack.back();
+        if(in.op == eoIfp) val0 = real(val0) > 0 ? val1 : val2;
+        else switch(in.arg == -1 ? 0 : int(real(slots[in.arg]) + .5)) {
+          case 1: break;
+          case 2: val0 = val1; break;
+          case 3: val0 = val2; break;
+          default: val0 = 0; break;
+          }
+        break;
+        }
+      #if CAP_ANIMATIONS
+      case eoAnim: {
+        cld *rest = &stack[isize(stack) - in.arg];
+        ld v = ticks * (in.arg-1.) / anims::period;
+        int vf = v;
+        v -= vf;
+        vf %= (in.arg-1);
+        cld res = rest[vf] + (rest[vf+1] - rest[vf]) * v;
+        stack.resize(isize(stack) - in.arg + 1);
+        stack.back() = res;
+        break;
+        }
+      #endif
+      case eoSeconds: stack.push_back(ticks / 1000.); break;
+      case eoMilliseconds: stack.push_back(ticks); break;
+      case eoMouseX: stack.push_back(mousex); break;
+      case eoMouseY: stack.push_back(mousey); break;
+      case eoMouseZ: stack.push_back(cld(mousex - current_display->xcenter, mousey - current_display->ycenter) / cld(current_display->radius, 0)); break;
+      case eoShot: stack.push_back(inHighQual ? 1 : 0); break;
+      default: break;
+      }
+    }
+  return stack.back();
+  }
+
 EX ld parseld(const string& s) {
   exp_parser ep;
   ep.s = s;
@@ -266,4 +533,65 @@ EX string parser_help() {
     "(a)sin(h), (a)cos(h), (a)tan(h), exp, log, abs, re, im, conj, let(t=...,...t...), floor, frac, e, i, pi, s, ms, mousex, mousey, mousez, shot [1 if taking screenshot/animation], to01, ifp(a,v,w) [if positive]");
   }
 
+
+#if CAP_THREAD
+#if HDR
+/** a pool of worker threads, started on the first use and then kept waiting for the next job,
+ *  so that the code run every frame does not create threads
+ */
+struct thread_pool {
+  vector<std::thread> workers;
+  std::mutex lock;
+  std::condition_variable start, done;
+  function<void(int)> job;
+  int generation = 0, jobs = 0, pending = 0;
+  bool quitting = false;
+  /** call f(0), ..., f(n-1); f(0) runs in the calling thread, the others in the workers; returns when all of them are done */
+  void run(int n, const function<void(int)>& f);
+  ~thread_pool();
+  };
+#endif
+
+void thread_pool::run(int n, const function<void(int)>& f) {
+  if(n <= 1) { if(n == 1) f(0); return; }
+  while(isize(workers) < n-1) {
+    int id = isize(workers) + 1;
+    workers.emplace_back([this, id] {
+      int seen = 0;
+      while(true) {
+        std::unique_lock<std::mutex> lk(lock);
+        start.wait(lk, [&] { return quitting || generation != seen; });
+        if(quitting) return;
+        seen = generation;
+        if(id >= jobs) continue;
+        lk.unlock();
+        job(id);
+        lk.lock();
+        if(--pending == 0) done.notify_one();
+        }
+      });
+    }
+  {
+    std::lock_guard<std::mutex> lk(lock);
+    job = f; jobs = n; pending = n-1;
+    generation++;
+    }
+  start.notify_all();
+  f(0);
+  std::unique_lock<std::mutex> lk(lock);
+  done.wait(lk, [&] { return pending == 0; });
+  }
+
+thread_pool::~thread_pool() {
+  {
+    std::lock_guard<std::mutex> lk(lock);
+    quitting = true;
+    }
+  start.notify_all();
+  for(auto& w: workers) w.join();
+  }
+
+/** the worker threads used for drawing */
+EX thread_pool draw_pool;
+#endif
 }